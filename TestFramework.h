@@ -12,14 +12,311 @@
 #include <QProcess>
 #include <QDebug>
 #include <QRegularExpression>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QImage>
+#include <QEventLoop>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+#include <QDeadlineTimer>
+#ifdef QT_NETWORK_LIB
+#include <QTcpServer>
+#include <QTcpSocket>
+#endif
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <new>
+#include <cstddef>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <charconv>
+#include <algorithm>
+#include <QtAlgorithms>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TFW_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define TFW_SIMD_SSE2
+#endif
+#ifdef Q_OS_LINUX
+#include <spawn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <execinfo.h>
+#include <cxxabi.h>
+extern char** environ;
+#endif
 #include "Exceptions.h"
 #include "Helper.h"
 #include "VersatileFile.h"
 
 namespace TFW
 {
+	///Resource usage of a tool call (only available on Linux)
+	struct ToolUsage
+	{
+		bool valid = false;
+		double user_s = 0.0; //user CPU time
+		double system_s = 0.0; //system CPU time
+		double max_rss_mb = 0.0; //peak resident set size
+		qint64 blocks_in = 0; //block input operations
+		qint64 blocks_out = 0; //block output operations
+		qint64 switches_voluntary = 0; //voluntary context switches
+		qint64 switches_involuntary = 0; //involuntary context switches
+
+		///Adds the usage of another tool call (the maximum is used for the RSS)
+		void add(const ToolUsage& other)
+		{
+			if (!other.valid) return;
+			valid = true;
+			user_s += other.user_s;
+			system_s += other.system_s;
+			max_rss_mb = std::max(max_rss_mb, other.max_rss_mb);
+			blocks_in += other.blocks_in;
+			blocks_out += other.blocks_out;
+			switches_voluntary += other.switches_voluntary;
+			switches_involuntary += other.switches_involuntary;
+		}
+
+		QByteArray toString() const
+		{
+			return "user " + QByteArray::number(user_s, 'f', 2) + "s, sys " + QByteArray::number(system_s, 'f', 2) + "s, max RSS " + QByteArray::number(max_rss_mb, 'f', 1) + " MB"
+				 + ", blocks in/out " + QByteArray::number(blocks_in) + "/" + QByteArray::number(blocks_out)
+				 + ", context switches vol/invol " + QByteArray::number(switches_voluntary) + "/" + QByteArray::number(switches_involuntary);
+		}
+	};
+
+	///Tool call of a test method (see TestExecutor::executeTool)
+	struct ToolCall
+	{
+		QString toolname;
+		QString arguments;
+		bool ignore_error_code;
+		QString file;
+		int line;
+		int handle = -1; //handle of an executeToolAsync call (-1 for executeTool)
+
+		QString log;
+#ifdef Q_OS_LINUX
+		pid_t pid = -1;
+#else
+		std::shared_ptr<QProcess> process;
+#endif
+		bool started = false;
+		bool finished = false;
+		int exit_code = -1;
+		bool timed_out = false; //killed because the timeout of the test method expired
+		QString error; //empty if successful
+		ToolUsage usage;
+	};
+
+	///Entry point of a tool that is executed in a forked child process instead of spawning its executable (see REGISTER_TOOL)
+	typedef int (*ToolEntry)(int argc, char** argv);
+
+	inline QHash<QString, ToolEntry>& registeredTools()
+	{
+		static QHash<QString, ToolEntry> tools;
+		return tools;
+	}
+
+	///Registers the entry point of a tool. EXECUTE calls of the tool fork the test process and call the entry point, instead of starting the tool executable (Linux only).
+	///The entry point must not create an application object (the test executable already has one) and must not rely on static destructors (the child exits with '_exit').
+	inline void registerTool(QString toolname, ToolEntry entry)
+	{
+		registeredTools()[toolname] = entry;
+	}
+
+	///Default timeout of test methods in seconds, 0 means no timeout (see --timeout and TEST_TIMEOUT)
+	inline int& defaultTimeout()
+	{
+		static int timeout = 0;
+		return timeout;
+	}
+
+	///Returns the last lines of a file, e.g. of a tool log
+	inline QByteArray fileTail(QString filename, int lines = 20)
+	{
+		QFile file(filename);
+		if (!file.open(QFile::ReadOnly|QFile::Text)) return "";
+		if (file.size()>65536) file.seek(file.size()-65536);
+		QList<QByteArray> parts = file.readAll().trimmed().split('\n');
+		return parts.mid(std::max(0, (int)parts.count()-lines)).join('\n');
+	}
+
+#ifdef Q_OS_LINUX
+	///Writes data to a file descriptor (also usable in signal handlers)
+	inline void writeFd(int fd, const char* data, size_t size)
+	{
+		while (size>0)
+		{
+			ssize_t written = write(fd, data, size);
+			if (written==-1 && errno==EINTR) continue;
+			if (written<=0) return;
+			data += written;
+			size -= written;
+		}
+	}
+
+	///Log file of the last tool started, stored as C string so that it can be used in signal handlers
+	inline char* lastLogPath()
+	{
+		static char path[4096] = "";
+		return path;
+	}
+
+	///File descriptor the backtrace is written to when the process receives SIGUSR2 (-1 if the handler is not installed)
+	inline int& backtraceFd()
+	{
+		static int fd = -1;
+		return fd;
+	}
+
+	///Process groups of the running tools, so that they can be killed in signal handlers (0 for unused entries)
+	inline std::array<std::atomic<pid_t>, 256>& runningToolGroups()
+	{
+		static std::array<std::atomic<pid_t>, 256> groups{};
+		return groups;
+	}
+
+	///Adds/removes the process group of a running tool (see runningToolGroups)
+	inline void trackToolGroup(pid_t pid, bool running)
+	{
+		for (std::atomic<pid_t>& group : runningToolGroups())
+		{
+			pid_t expected = running ? 0 : pid;
+			if (group.compare_exchange_strong(expected, running ? pid : 0)) return;
+		}
+	}
+
+	//Writes a marker line with the last tool log and a backtrace to backtraceFd(), kills the running tools and terminates the process
+	inline void handleTimeoutSignal(int)
+	{
+		for (std::atomic<pid_t>& group : runningToolGroups()) //otherwise orphaned tools (e.g. of EXECUTE_ASYNC) keep running
+		{
+			pid_t pid = group.load();
+			if (pid>0) kill(-pid, SIGKILL);
+		}
+
+		int fd = backtraceFd();
+		const char marker[] = "TFW_BACKTRACE\t";
+		writeFd(fd, marker, sizeof(marker)-1);
+		writeFd(fd, lastLogPath(), strlen(lastLogPath()));
+		writeFd(fd, "\n", 1);
+		void* frames[64];
+		int depth = backtrace(frames, 64);
+		backtrace_symbols_fd(frames, depth, fd);
+		_exit(124);
+	}
+
+	///Installs a SIGUSR2 handler that writes a backtrace to the given file descriptor. Used by the watchdog of worker and forked test processes, see timeoutMessage().
+	inline void installBacktraceHandler(int fd)
+	{
+		void* dummy[1];
+		backtrace(dummy, 1); //backtrace() allocates memory on the first call
+		backtraceFd() = fd;
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = &handleTimeoutSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGUSR2, &action, nullptr);
+	}
+#endif
+
+	///Returns the message of a test method that was killed by the watchdog. 'output' is the output of the killed process, which contains the backtrace written by the SIGUSR2 handler.
+	inline QByteArray timeoutMessage(int timeout, QByteArray output)
+	{
+		QByteArray message = "timeout  : test method killed after " + QByteArray::number(timeout) + "s";
+		int pos = output.indexOf("TFW_BACKTRACE\t");
+		if (pos==-1) return message;
+
+		QList<QByteArray> lines = output.mid(pos).trimmed().split('\n');
+		QByteArray log = lines.takeFirst().mid(14).trimmed();
+		if (!log.isEmpty())
+		{
+			message += "\nlast lines of " + log + ":\n" + fileTail(log);
+		}
+		message += "\nbacktrace:\n" + lines.join('\n');
+		return message;
+	}
+
+	///Status of the test method executed in the current thread
+	struct TestContext
+	{
+		bool skipped = false;
+		bool failed = false;
+		QByteArray message;
+		QString last_log;
+		QList<std::shared_ptr<ToolCall>> tool_calls; //calls of executeToolAsync
+		QStringList dependencies; //tools and test data files used by the test (absolute paths)
+		ToolUsage last_usage; //resource usage of the last finished tool call
+		ToolUsage tool_usage; //resource usage of all tool calls of the test
+		QDeadlineTimer deadline{QDeadlineTimer::Forever}; //end of the timeout of the test method (tools are killed when it expires)
+		int timeout = 0; //timeout of the test method in seconds (0 if there is none)
+	};
+
+	inline TestContext& context()
+	{
+		thread_local TestContext context;
+		return context;
+	}
+
+	///Heap allocation counters of the current thread. Allocations are only counted if TFW_ALLOC_HOOK is defined in one source file of the test executable.
+	struct AllocCounters
+	{
+		qint64 allocations;
+		qint64 bytes;
+		qint64 live_bytes;
+		qint64 peak_live_bytes;
+	};
+
+	inline AllocCounters& allocCounters()
+	{
+		thread_local AllocCounters counters = {0, 0, 0, 0};
+		return counters;
+	}
+
+	///Returns if the allocation hook is compiled into the test executable (see TFW_ALLOC_HOOK)
+	inline bool& allocHookInstalled()
+	{
+		static bool installed = false;
+		return installed;
+	}
+
+	inline QByteArray currentExceptionMessage();
+
+	///Thrown to skip the calling test method, e.g. if a fixture it uses was skipped (see TestExecutor::fixture)
+	struct TestSkipped
+	{
+		QByteArray message;
+	};
+
     class TestExecutor
     {
     public:
@@ -27,6 +324,77 @@ namespace TFW
         {
         }
 
+		virtual ~TestExecutor()
+		{
+		}
+
+		///Executed once per process before the first test method of the class (see TEST_CLASS_SETUP)
+		virtual void classSetup()
+		{
+		}
+
+		///Executed once per process after the last test method of the class, if the setup was successful (see TEST_CLASS_TEARDOWN)
+		virtual void classTeardown()
+		{
+		}
+
+		///Returns a fixture shared by the test methods of the class, e.g. a preprocessed input file. It is created by 'init' on first use and cached until the process ends.
+		///If 'init' fails (e.g. in an EXECUTE macro) or throws an exception, an exception is thrown. If 'init' skips (e.g. SKIP_IF_NO_TEST_NGSD), the calling test method is skipped.
+		///The result is cached in both cases, so that 'init' is not repeated by each test method. Tools and test data used by 'init' are dependencies of each calling test method (see --incremental).
+		///'init' is executed within the timeout of the calling test method. Tools started with EXECUTE_ASYNC are waited for after 'init'.
+		///Fixtures are cached per process: with worker processes (-j) each worker creates its own copy, and with --fork each test method does. Use TEST_CLASS_SETUP for preprocessing that has to be done only once per run.
+		template <typename T>
+		const T& fixture(const QByteArray& key, std::function<void(T&)> init)
+		{
+			std::lock_guard<std::recursive_mutex> lock(fixture_mutex_);
+			if (!fixtures_.contains(key))
+			{
+				//execute 'init' with a clean context, but within the timeout of the calling test method
+				TestContext caller = std::move(context());
+				context() = TestContext();
+				TestContext& ctx = context();
+				ctx.deadline = caller.deadline;
+				ctx.timeout = caller.timeout;
+
+				std::shared_ptr<T> value = std::make_shared<T>();
+				try
+				{
+					init(*value);
+				}
+				catch (TestSkipped& e)
+				{
+					ctx.message = e.message;
+					ctx.skipped = true;
+				}
+				catch (...)
+				{
+					ctx.message = currentExceptionMessage();
+					ctx.failed = true;
+				}
+				QString tool_errors = waitForTools();
+				if (!ctx.failed && !ctx.skipped && !tool_errors.isEmpty())
+				{
+					ctx.message = tool_errors.toUtf8();
+					ctx.failed = true;
+				}
+				Fixture& entry = fixtures_[key];
+				entry.value = value;
+				entry.failed = ctx.failed;
+				entry.skipped = ctx.skipped && !ctx.failed;
+				entry.message = ctx.message;
+				entry.dependencies = ctx.dependencies;
+
+				caller.tool_usage.add(ctx.tool_usage);
+				context() = std::move(caller);
+			}
+
+			const Fixture& entry = fixtures_[key];
+			context().dependencies << entry.dependencies;
+			if (entry.failed) THROW(Exception, "Fixture '" + QString(key) + "' could not be created:\n" + QString(entry.message));
+			if (entry.skipped) throw TestSkipped{entry.message};
+			return *std::static_pointer_cast<T>(entry.value);
+		}
+
         const QByteArray& name() const
         {
             return name_;
@@ -52,13 +420,168 @@ namespace TFW
 		//Get log file of last executeTool call
 		QString lastLogFile()
 		{
-			return last_log_;
+			return context().last_log;
 		}
 
 		///Executes a tool and returns (1) if the execution was successful (2) the error message if it was not successful
 		QString executeTool(QString toolname, QString arguments, bool ignore_error_code, QString file, int line)
 		{
-			if (QFile::exists(toolname)) //Linux
+			ToolCall call{toolname, arguments, ignore_error_code, file, line};
+			startTool(call);
+			finishTool(call);
+			return call.error;
+		}
+
+		///Starts a tool without waiting for it to finish and returns a handle for asyncLogFile() and asyncExitCode(). Errors are reported by waitForTools().
+		int executeToolAsync(QString toolname, QString arguments, bool ignore_error_code, QString file, int line)
+		{
+			QList<std::shared_ptr<ToolCall>>& calls = context().tool_calls;
+
+			//limit number of running tools
+			int running = 0;
+			foreach(const std::shared_ptr<ToolCall>& call, calls)
+			{
+				if (!call->finished) ++running;
+			}
+			for (int i=0; i<calls.count() && running>=maxParallelTools(); ++i)
+			{
+				if (calls[i]->finished) continue;
+				finishTool(*calls[i]);
+				--running;
+			}
+
+			std::shared_ptr<ToolCall> call(new ToolCall{toolname, arguments, ignore_error_code, file, line});
+			call->handle = calls.count();
+			startTool(*call);
+			calls << call;
+			return calls.count()-1;
+		}
+
+		///Waits for all tools started by executeToolAsync(). Returns an empty string if all were successful, or the error messages of the failed calls.
+		QString waitForTools()
+		{
+			QString output;
+			foreach(const std::shared_ptr<ToolCall>& call, context().tool_calls)
+			{
+				finishTool(*call);
+				if (call->error.isEmpty()) continue;
+
+				output += "EXECUTE_ASYNC(" + call->toolname + ", " + call->arguments + ") at " + QFileInfo(call->file).fileName() + ":" + QString::number(call->line) + "\n" + call->error + "\n";
+			}
+			return output.trimmed();
+		}
+
+		//Get log file of an executeToolAsync call
+		QString asyncLogFile(int handle)
+		{
+			return context().tool_calls[handle]->log;
+		}
+
+		//Get exit code of an executeToolAsync call (-1 if it has not finished yet or could not be started)
+		int asyncExitCode(int handle)
+		{
+			return context().tool_calls[handle]->exit_code;
+		}
+
+		///Runs the body of a benchmark method with warmup and repetitions and reports min/median/MAD/throughput. The statistics are also appended to the file benchmarkFile().
+		void runBenchmark(const QByteArray& method_name, std::function<void()> body)
+		{
+			TestContext& ctx = context();
+			for (int i=0; i<benchmarkWarmup(); ++i)
+			{
+				body();
+				if (ctx.failed || ctx.skipped) return;
+			}
+
+			std::vector<qint64> times;
+			for (int i=0; i<benchmarkIterations(); ++i)
+			{
+				QElapsedTimer timer;
+				timer.start();
+				body();
+				qint64 ns = timer.nsecsElapsed();
+				if (ctx.failed || ctx.skipped) return;
+				times.push_back(ns);
+			}
+
+			//statistics
+			auto median = [](std::vector<qint64> values)
+			{
+				std::sort(values.begin(), values.end());
+				size_t n = values.size();
+				return n%2==1 ? values[n/2] : (values[n/2-1] + values[n/2]) / 2;
+			};
+			qint64 min = *std::min_element(times.begin(), times.end());
+			qint64 med = median(times);
+			std::vector<qint64> deviations;
+			for (qint64 time : times)
+			{
+				deviations.push_back(std::llabs(time - med));
+			}
+			qint64 mad = median(deviations);
+			double per_second = med>0 ? 1e9 / med : 0.0;
+
+			ctx.message = "benchmark: " + QByteArray::number(benchmarkIterations()) + " iterations (" + QByteArray::number(benchmarkWarmup()) + " warmup)\n"
+						+ "min      : " + QByteArray::number(min/1e6, 'f', 3) + " ms\n"
+						+ "median   : " + QByteArray::number(med/1e6, 'f', 3) + " ms\n"
+						+ "MAD      : " + QByteArray::number(mad/1e6, 'f', 3) + " ms\n"
+						+ "per sec  : " + QByteArray::number(per_second, 'f', 2);
+
+			//append to results file
+			static QMutex mutex;
+			QMutexLocker locker(&mutex);
+			QFile file(benchmarkFile());
+			bool write_header = !file.exists();
+			if (!file.open(QFile::Append|QFile::Text)) return;
+			if (write_header) file.write("date,test,warmup,iterations,min_ns,median_ns,mad_ns,per_second\n");
+			QByteArrayList fields;
+			fields << QDateTime::currentDateTime().toString(Qt::ISODate).toUtf8() << name_ + "::" + method_name << QByteArray::number(benchmarkWarmup()) << QByteArray::number(benchmarkIterations());
+			fields << QByteArray::number(min) << QByteArray::number(med) << QByteArray::number(mad) << QByteArray::number(per_second, 'f', 2);
+			file.write(fields.join(',') + "\n");
+		}
+
+		///Number of warmup runs of benchmark methods
+		static int& benchmarkWarmup()
+		{
+			static int warmup = 1;
+			return warmup;
+		}
+
+		///Number of timed runs of benchmark methods
+		static int& benchmarkIterations()
+		{
+			static int iterations = 10;
+			return iterations;
+		}
+
+		///CSV file benchmark results are appended to
+		static QString& benchmarkFile()
+		{
+			static QString file = "out/tfw_benchmarks.csv";
+			return file;
+		}
+
+		///Maximum number of tools started by executeToolAsync() that run at the same time
+		static int& maxParallelTools()
+		{
+			static int max = std::max(1, QThread::idealThreadCount());
+			return max;
+		}
+
+	protected:
+		//Resolves the tool and starts it
+		static void startTool(ToolCall& call)
+		{
+#ifdef Q_OS_LINUX
+			ToolEntry entry = registeredTools().value(call.toolname, nullptr);
+#else
+			ToolEntry entry = nullptr;
+#endif
+			QString toolname = call.toolname;
+			if (entry!=nullptr) //registered in the test executable
+			{
+			}
+			else if (QFile::exists(toolname)) //Linux
 			{
 				toolname = "./" + toolname;
 			}
@@ -68,37 +591,224 @@ namespace TFW
 			}
 			else
 			{
-				return "Tool '" + toolname + "' not found!";
+				call.error = "Tool '" + toolname + "' not found!";
+				call.finished = true;
+				return;
 			}
 
-			QProcess process;
-			last_log_ = "out/" + QFileInfo(file).baseName() + "_line" + QString::number(line) + ".log";
-			process.setProcessChannelMode(QProcess::MergedChannels);
-			process.setStandardOutputFile(last_log_);
-			QStringList arg_split = arguments.simplified().trimmed().split(' ');
+			if (entry==nullptr) context().dependencies << QFileInfo(toolname).absoluteFilePath();
+			call.log = "out/" + QFileInfo(call.file).baseName() + "_line" + QString::number(call.line) + (call.handle==-1 ? "" : "_" + QString::number(call.handle)) + ".log"; //async calls from a loop must not share the log file
+			context().last_log = call.log;
+#ifdef Q_OS_LINUX
+			if (backtraceFd()!=-1) qstrncpy(lastLogPath(), QFile::encodeName(call.log).constData(), 4096);
+#endif
+			QStringList arg_split = call.arguments.simplified().trimmed().split(' ');
 			for(int i=0; i<arg_split.count(); ++i)
 			{
 				arg_split[i].replace("%20", " ");
 			}
-			process.start(toolname, arg_split);
-			bool started = process.waitForStarted(-1);
-			bool finished = process.waitForFinished(-1);
-			int exit_code = process.exitCode();
-			if (!started || !finished || (!ignore_error_code && exit_code!=0))
+
+#ifdef Q_OS_LINUX
+			//spawn the process directly (instead of using QProcess), so that the resource usage can be collected with wait4()
+			QByteArray program = QFile::encodeName(toolname);
+			QByteArray log = QFile::encodeName(call.log);
+			QList<QByteArray> args;
+			args << program;
+			foreach(const QString& arg, arg_split)
+			{
+				args << arg.toLocal8Bit();
+			}
+			std::vector<char*> argv;
+			for (QByteArray& arg : args)
+			{
+				argv.push_back(arg.data());
+			}
+			argv.push_back(nullptr);
+
+			int error = 0;
+			if (entry!=nullptr)
+			{
+				//fork and call the registered entry point (with the same process group and redirections as spawned tools)
+				fflush(nullptr);
+				call.pid = fork();
+				if (call.pid==0)
+				{
+					setpgid(0, 0);
+					if (backtraceFd()>STDERR_FILENO) close(backtraceFd()); //result pipe of --fork
+					int in_fd = ::open("/dev/null", O_RDONLY);
+					int log_fd = ::open(log.constData(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+					if (in_fd==-1 || log_fd==-1) _exit(127);
+					dup2(in_fd, 0);
+					dup2(log_fd, 1);
+					dup2(log_fd, 2);
+					int exit_code = 1;
+					try
+					{
+						exit_code = entry((int)argv.size()-1, argv.data());
+					}
+					catch (Exception& e)
+					{
+						fprintf(stderr, "Uncaught exception: %s\n", e.message().toLocal8Bit().constData());
+					}
+					catch (std::exception& e)
+					{
+						fprintf(stderr, "Uncaught exception: %s\n", e.what());
+					}
+					catch (...)
+					{
+						fprintf(stderr, "Uncaught exception\n");
+					}
+					fflush(nullptr);
+					_exit(exit_code);
+				}
+				if (call.pid==-1) error = errno;
+				else setpgid(call.pid, call.pid); //also in the parent, so that kill(-pid) works even if the child did not call setpgid yet
+			}
+			else
+			{
+				posix_spawn_file_actions_t actions;
+				posix_spawn_file_actions_init(&actions);
+				posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+				posix_spawn_file_actions_addopen(&actions, 1, log.constData(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+				posix_spawn_file_actions_adddup2(&actions, 1, 2);
+				posix_spawnattr_t attributes;
+				posix_spawnattr_init(&attributes);
+				posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+				posix_spawnattr_setpgroup(&attributes, 0);
+				error = posix_spawn(&call.pid, program.constData(), &actions, &attributes, argv.data(), environ);
+				posix_spawnattr_destroy(&attributes);
+				posix_spawn_file_actions_destroy(&actions);
+			}
+			call.started = error==0;
+			if (call.started) trackToolGroup(call.pid, true);
+			if (!call.started)
+			{
+				call.pid = -1;
+				call.error = "Tool '" + toolname + "' could not be started: " + QString::fromLocal8Bit(strerror(error));
+				call.finished = true;
+			}
+#else
+			call.process.reset(new QProcess());
+			call.process->setProcessChannelMode(QProcess::MergedChannels);
+			call.process->setStandardOutputFile(call.log);
+			call.process->start(toolname, arg_split);
+			call.started = call.process->waitForStarted(-1);
+#endif
+		}
+
+		//Waits until the tool is finished and checks the exit code
+		static void finishTool(ToolCall& call)
+		{
+			if (call.finished) return;
+			call.finished = true;
+
+#ifdef Q_OS_LINUX
+			int status = 0;
+			struct rusage usage;
+			pid_t waited;
+			const QDeadlineTimer& deadline = context().deadline;
+			if (!deadline.isForever()) //block until the tool exits - a watchdog thread kills the process group of the tool when the timeout of the test method expires
+			{
+				std::chrono::nanoseconds remaining(std::max((qint64)0, deadline.remainingTimeNSecs()));
+				std::mutex mutex;
+				std::condition_variable exited;
+				bool done = false;
+				std::thread watchdog([&]()
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					if (!exited.wait_for(lock, remaining, [&]() { return done; }))
+					{
+						call.timed_out = true;
+						kill(-call.pid, SIGKILL);
+					}
+				});
+				siginfo_t info;
+				while (waitid(P_PID, call.pid, &info, WEXITED|WNOWAIT)==-1 && errno==EINTR) {} //does not reap the tool, so its pid cannot be reused before the watchdog is stopped
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					done = true;
+				}
+				exited.notify_one();
+				watchdog.join();
+			}
+			do
+			{
+				waited = wait4(call.pid, &status, 0, &usage);
+			}
+			while (waited==-1 && errno==EINTR);
+			if (call.started) trackToolGroup(call.pid, false);
+			bool finished = waited==call.pid;
+			bool crashed = finished && WIFSIGNALED(status);
+			int exit_code = finished && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+			if (finished)
+			{
+				call.usage.valid = true;
+				call.usage.user_s = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+				call.usage.system_s = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+				call.usage.max_rss_mb = usage.ru_maxrss / 1024.0;
+				call.usage.blocks_in = usage.ru_inblock;
+				call.usage.blocks_out = usage.ru_oublock;
+				call.usage.switches_voluntary = usage.ru_nvcsw;
+				call.usage.switches_involuntary = usage.ru_nivcsw;
+				context().last_usage = call.usage;
+				context().tool_usage.add(call.usage);
+			}
+			if (crashed && !call.ignore_error_code) finished = false;
+#else
+			const QDeadlineTimer& deadline = context().deadline;
+			bool finished = call.process->waitForFinished(deadline.isForever() ? -1 : std::max((qint64)0, deadline.remainingTime()));
+			if (!finished && call.process->state()!=QProcess::NotRunning)
+			{
+				call.timed_out = true;
+				call.process->kill();
+				call.process->waitForFinished(-1);
+			}
+			int exit_code = call.process->exitCode();
+#endif
+			if (call.timed_out)
+			{
+				call.error = "timeout: tool killed after the timeout of the test method (" + QString::number(context().timeout) + "s)\nlast lines of tool output:\n" + fileTail(call.log);
+				return;
+			}
+			if (call.started && finished) call.exit_code = exit_code;
+			if (!call.started || !finished || (!call.ignore_error_code && exit_code!=0))
 			{
 				QByteArray result = "exit code: " + QByteArray::number(exit_code);
-				QFile tmp_file(last_log_);
+#ifdef Q_OS_LINUX
+				if (crashed) result += " (terminated by signal " + QByteArray::number(WTERMSIG(status)) + ")";
+#endif
+				QFile tmp_file(call.log);
 				tmp_file.open(QFile::ReadOnly|QFile::Text);
 				result += "\ntool output:\n" + tmp_file.readAll().trimmed();
-				return result;
+				call.error = result;
 			}
-			return "";
 		}
 
-    protected:
+		//Kills a tool that is still running
+		static void abortTool(ToolCall& call)
+		{
+			if (call.finished) return;
+#ifdef Q_OS_LINUX
+			kill(-call.pid, SIGKILL); //process group of the tool
+#else
+			call.process->kill();
+#endif
+			finishTool(call);
+		}
+
         QByteArray name_;
         QList<QPair<QByteArray, std::function<void()>>> tests_;
-		QString last_log_;
+
+		struct Fixture
+		{
+			std::shared_ptr<void> value;
+			bool failed = false;
+			bool skipped = false;
+			QByteArray message; //message of the failure/skip
+			QStringList dependencies; //tools and test data files used by 'init'
+		};
+		QHash<QByteArray, Fixture> fixtures_;
+		std::recursive_mutex fixture_mutex_;
     };
 
 	//############## helper functions ##################
@@ -108,6 +818,32 @@ namespace TFW
 		return QFileInfo(filename).fileName().toUtf8();
 	}
 
+	///Returns the message for the exception that is currently handled (only call in a catch block)
+	inline QByteArray currentExceptionMessage()
+	{
+		QByteArray msg;
+		try
+		{
+			throw;
+		}
+		catch (Exception& e)
+		{
+			msg += "exception: Exception (cppCORE)\n";
+			msg += "location : " + name(e.file()) + ":" + QByteArray::number(e.line()) + "\n";
+			msg += "message  : " + e.message().toUtf8() + "\n";
+		}
+		catch (std::exception& e)
+		{
+			msg += "exception: std::exception\n";
+			msg += "message  : " + QByteArray(e.what()) + "\n";
+		}
+		catch (...)
+		{
+			msg = "unknown exception";
+		}
+		return msg;
+	}
+
 	inline QByteArray number(int num)
 	{
 		return QByteArray::number(num);
@@ -155,6 +891,7 @@ namespace TFW
 		final_path = QFileInfo(test_cpp_file).absolutePath().toUtf8() + "/" + testfile;
 
 		if (!QFile::exists(final_path)) THROW(ProgrammingException, "Could not find test file '" + testfile + "' relative to '"+test_cpp_file_original+"'. It's not at: " + final_path);
+		context().dependencies << QFileInfo(final_path).absoluteFilePath();
 		return final_path;
 	}
 
@@ -162,201 +899,2390 @@ namespace TFW
 
 	inline bool& skipped()
 	{
-		static bool skipped = false;
-		return skipped;
+		return context().skipped;
 	}
 
 	inline bool& failed()
 	{
-		static bool failed = false;
-		return failed;
+		return context().failed;
 	}
 
 	inline QByteArray& message()
 	{
-		static QByteArray message;
-		return message;
+		return context().message;
 	}
 
-	//############### test execution ##################
-
-    inline QList<TestExecutor*>& testList()
+	///Mutex for output written from several test threads
+	inline QMutex& outputMutex()
 	{
-        static QList<TestExecutor*> list;
-		return list;
+		static QMutex mutex;
+		return mutex;
 	}
 
-    inline void addTest(TestExecutor* test)
-    {
-        QList<TestExecutor*>& list = testList();
-        foreach (TestExecutor* test2, list)
+	//############### test execution ##################
+
+	///Registered test class. The instance is created on first use, so that only test classes with selected test methods are constructed.
+	class TestClass
+	{
+	public:
+		TestClass(QByteArray name, const void* key, std::function<TestExecutor*()> factory)
+			: name_(name)
+			, key_(key)
+			, factory_(factory)
+			, instance_(nullptr)
 		{
-			if (test2->name()==test->name()) return;
 		}
-        list.append(test);
-	}
 
-	inline int run(int argc, char *argv[])
-    {
-		//create a QApplication to be able to use a event loop (e.g. for XML validation)
-		QApplication core_app(argc, argv);
+		const QByteArray& name() const
+		{
+			return name_;
+		}
 
-		//parse command line parameters
-		QCommandLineParser parser;
-		parser.addOption(QCommandLineOption("s", "Test case string filter for test cases.", "s"));
-		parser.addOption(QCommandLineOption("l", "Test case list to execute.", "l"));
-		parser.addOption(QCommandLineOption("d", "Enable debug output."));
-		parser.addHelpOption();
-		parser.process(core_app);
-		QByteArray s_filter = parser.value("s").toUtf8();
-		QStringList l_filter;
-		if (parser.value("l")!="")
+		///Key identifying the class type (see TypeKey)
+		const void* key() const
 		{
-			try
-			{
-				l_filter = Helper::loadTextFile(parser.value("l"), true, '#', true);
-			}
-			catch(Exception e)
-			{
-				qDebug() << "Error loading filter list " << parser.value("l");
-				qDebug() << e.message();
-				return -1;
-			}
+			return key_;
 		}
-		bool debug_output = parser.isSet("d");
 
-		//create folder for test output data
-		QDir(".").mkdir("out");
+		///Creates the test class instance and executes the class setup, if not done yet (once per process)
+		void prepare()
+		{
+			std::call_once(created_, [this]()
+			{
+				instance_ = factory_();
+				instance_->setName(name_);
+
+				//execute setup with a clean context: the context of the calling thread can belong to another test method, e.g. with an expired deadline
+				TestContext caller = std::move(context());
+				context() = TestContext();
+				if (defaultTimeout()>0) //setup has the default timeout, independent of the test method that triggers it
+				{
+					context().timeout = defaultTimeout();
+					context().deadline.setRemainingTime((qint64)defaultTimeout() * 1000);
+				}
+				try
+				{
+					instance_->classSetup();
+				}
+				catch (TestSkipped& e)
+				{
+					message() = e.message;
+					skipped() = true;
+				}
+				catch (...)
+				{
+					message() = currentExceptionMessage();
+					failed() = true;
+				}
+				QString tool_errors = instance_->waitForTools();
+				if (!failed() && !skipped() && !tool_errors.isEmpty())
+				{
+					message() = tool_errors.toUtf8();
+					failed() = true;
+				}
+				setup_result_ = failed() ? "FAIL!" : (skipped() ? "SKIP" : "PASS");
+				setup_message_ = message();
+				setup_dependencies_ = context().dependencies;
+				context() = std::move(caller);
+			});
+		}
+
+		///Returns the result of the class setup ('PASS', 'SKIP' or 'FAIL!'), see prepare()
+		const QByteArray& setupResult() const
+		{
+			return setup_result_;
+		}
+
+		///Returns the message of the class setup
+		const QByteArray& setupMessage() const
+		{
+			return setup_message_;
+		}
+
+		///Returns the tools and test data files used by the class setup
+		const QStringList& setupDependencies() const
+		{
+			return setup_dependencies_;
+		}
+
+		///Returns 'true' only for the first call, i.e. for the test method that reports a failed setup
+		bool reportSetupFailure()
+		{
+			return !setup_failure_reported_.exchange(true);
+		}
+
+		///Executes the class teardown, if the instance was created and the setup was successful. Returns the error message, or an empty string if successful.
+		QByteArray teardown()
+		{
+			if (instance_==nullptr || setup_result_!="PASS" || torn_down_) return "";
+			torn_down_ = true;
+
+			context() = TestContext();
+			try
+			{
+				instance_->classTeardown();
+			}
+			catch (...)
+			{
+				message() = currentExceptionMessage();
+				failed() = true;
+			}
+			return failed() ? message() : "";
+		}
+
+		///Returns the test method with the given name (creates the test class instance if necessary)
+		std::function<void()> method(const QByteArray& method_name)
+		{
+			prepare();
+			for (int i=0; i<instance_->testCount(); ++i)
+			{
+				if (instance_->methodName(i)==method_name) return instance_->method(i);
+			}
+			THROW(ProgrammingException, "Test method '" + QString(method_name) + "' not found in test class '" + QString(name_) + "'!");
+		}
+
+	protected:
+		QByteArray name_;
+		const void* key_;
+		std::function<TestExecutor*()> factory_;
+		TestExecutor* instance_;
+		std::once_flag created_;
+		QByteArray setup_result_;
+		QByteArray setup_message_;
+		QStringList setup_dependencies_;
+		std::atomic<bool> setup_failure_reported_{false};
+		bool torn_down_ = false;
+	};
+
+	///Unique key of a type, used to associate statically registered test methods with their test class
+	template <class T>
+	struct TypeKey
+	{
+		static const char key;
+	};
+	template <class T>
+	const char TypeKey<T>::key = 0;
+
+	inline QList<TestClass*>& testClasses()
+	{
+		static QList<TestClass*> list;
+		return list;
+	}
+
+	///Names of test methods per test class type (registered statically by TEST_METHOD, in declaration order)
+	inline QHash<const void*, QByteArrayList>& testMethods()
+	{
+		static QHash<const void*, QByteArrayList> methods;
+		return methods;
+	}
+
+	///Timeouts of test methods in seconds per test class type (registered statically by TEST_TIMEOUT)
+	inline QHash<const void*, QHash<QByteArray, int>>& testTimeouts()
+	{
+		static QHash<const void*, QHash<QByteArray, int>> timeouts;
+		return timeouts;
+	}
+
+	///Resources used by the test methods of a test class type (registered statically by USES_RESOURCE)
+	inline QHash<const void*, QHash<QByteArray, int>>& testResources()
+	{
+		static QHash<const void*, QHash<QByteArray, int>> resources;
+		return resources;
+	}
+
+	///Memory in MB used by the test methods of a test class type (registered statically by MEMORY_MB)
+	inline QHash<const void*, int>& testMemory()
+	{
+		static QHash<const void*, int> memory;
+		return memory;
+	}
+
+	///Test class types with setup or teardown (registered statically by TEST_CLASS_SETUP and TEST_CLASS_TEARDOWN)
+	inline QSet<const void*>& classesWithSetup()
+	{
+		static QSet<const void*> classes;
+		return classes;
+	}
+
+	///Returns if a test class needs a QApplication (see TEST_NEEDS_GUI)
+	inline bool& needsGui()
+	{
+		static bool needs_gui = false;
+		return needs_gui;
+	}
+
+	inline void addTest(QByteArray name, const void* key, std::function<TestExecutor*()> factory)
+	{
+		foreach (TestClass* test_class, testClasses())
+		{
+			if (test_class->name()==name) return;
+		}
+		testClasses().append(new TestClass(name, key, factory));
+	}
+
+	///Executes the teardown of all test classes that were set up in this process. Failures are written to the output stream, but not counted as failed tests.
+	inline void teardownClasses(QFile& outstream)
+	{
+		foreach(TestClass* test_class, testClasses())
+		{
+			QByteArray error = test_class->teardown();
+			if (error.isEmpty()) continue;
+
+			QMutexLocker locker(&outputMutex());
+			outstream.write("WARNING: class teardown of " + test_class->name() + " failed:\n");
+			foreach(const QByteArray& line, error.trimmed().split('\n'))
+			{
+				outstream.write("  " + line.trimmed() + "\n");
+			}
+			outstream.flush();
+		}
+	}
+
+	///Test method selected for execution
+	struct TestCase
+	{
+		TestClass* test;
+		QByteArray method;
+		QByteArray name; //'class::method'
+		int timeout = 0; //seconds, 0 if there is none
+		QHash<QByteArray, int> resources; //resource name > units used (see USES_RESOURCE)
+		int memory_mb = 0; //memory used (see MEMORY_MB)
+	};
+
+	///Hardware performance counters of a test method, including all threads and child processes started while counting (Linux only, see --counters)
+	class PerfCounters
+	{
+	public:
+		PerfCounters()
+		{
+			fds_.fill(-1);
+		}
+
+		~PerfCounters()
+		{
+#ifdef Q_OS_LINUX
+			for (int fd : fds_)
+			{
+				if (fd!=-1) close(fd);
+			}
+#endif
+		}
+
+		///Returns if the counters are enabled (see --counters)
+		static bool& enabled()
+		{
+			static bool enabled = false;
+			return enabled;
+		}
+
+		///Opens the counters for the calling thread. Returns an error message if they are not available.
+		QByteArray open()
+		{
+#ifdef Q_OS_LINUX
+			const quint64 events[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+			for (int i=0; i<4; ++i)
+			{
+				struct perf_event_attr attr;
+				memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = events[i];
+				attr.disabled = 1;
+				attr.inherit = 1;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				fds_[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+				if (fds_[i]==-1) return "perf_event_open failed: " + QByteArray(strerror(errno)) + " (see /proc/sys/kernel/perf_event_paranoid)";
+			}
+			return "";
+#else
+			return "not supported on this platform";
+#endif
+		}
+
+		///Resets and starts the counters
+		void start()
+		{
+#ifdef Q_OS_LINUX
+			for (int fd : fds_)
+			{
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		///Stops the counters and returns the values as text
+		QByteArray stop()
+		{
+			std::array<double, 4> values;
+			values.fill(0.0);
+#ifdef Q_OS_LINUX
+			for (int i=0; i<4; ++i)
+			{
+				ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+				quint64 data[3]; //value, time enabled, time running
+				if (read(fds_[i], data, sizeof(data))!=sizeof(data)) continue;
+				values[i] = data[2]==0 ? 0.0 : data[0] * ((double)data[1] / data[2]); //scale if counters were multiplexed
+			}
+#endif
+			auto format = [](double value)
+			{
+				if (value>=1e9) return QByteArray::number(value/1e9, 'f', 2) + "G";
+				if (value>=1e6) return QByteArray::number(value/1e6, 'f', 2) + "M";
+				if (value>=1e3) return QByteArray::number(value/1e3, 'f', 2) + "K";
+				return QByteArray::number(value, 'f', 0);
+			};
+			return "cycles " + format(values[0]) + ", instructions " + format(values[1]) + ", IPC " + QByteArray::number(values[0]>0 ? values[1]/values[0] : 0.0, 'f', 2)
+				 + ", cache misses " + format(values[2]) + ", branch misses " + format(values[3]);
+		}
+
+	protected:
+		std::array<int, 4> fds_;
+	};
+
+	///Sampling profiler for test methods based on SIGPROF and backtrace() (Linux only, see --profile).
+	///Samples are written as folded stacks, which can be converted to flame graphs. Function names of the executable are only available if it is linked with '-rdynamic'.
+	class SamplingProfiler
+	{
+	public:
+		///Returns if profiling is enabled (see --profile)
+		static bool& enabled()
+		{
+			static bool enabled = false;
+			return enabled;
+		}
+
+		///Starts sampling the current process
+		static void start()
+		{
+#ifdef Q_OS_LINUX
+			//initialize buffers and backtrace() before the first signal arrives (backtrace() allocates memory on the first call)
+			samples();
+			sampleCount() = 0;
+			void* dummy[1];
+			backtrace(dummy, 1);
+
+			struct sigaction action;
+			memset(&action, 0, sizeof(action));
+			action.sa_handler = &SamplingProfiler::handleSignal;
+			action.sa_flags = SA_RESTART;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGPROF, &action, nullptr);
+
+			struct itimerval timer;
+			timer.it_interval.tv_sec = 0;
+			timer.it_interval.tv_usec = 1000000 / frequency;
+			timer.it_value = timer.it_interval;
+			setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+		}
+
+		///Stops sampling and writes the folded stacks to the given file
+		static void stop(QString filename)
+		{
+#ifdef Q_OS_LINUX
+			struct itimerval timer;
+			memset(&timer, 0, sizeof(timer));
+			setitimer(ITIMER_PROF, &timer, nullptr);
+
+			int count = sampleCount().load();
+			if (count>max_samples) count = max_samples;
+			QHash<void*, QByteArray> symbols = symbolize(count);
+
+			//fold stacks (the first frames are the signal handler and the signal trampoline)
+			const int skipped_frames = 2;
+			QHash<QByteArray, int> stacks;
+			for (int i=0; i<count; ++i)
+			{
+				const Sample& sample = samples()[i];
+				QByteArrayList names;
+				for (int j=sample.depth-1; j>=skipped_frames; --j)
+				{
+					names << symbols[sample.frames[j]];
+				}
+				if (!names.isEmpty()) ++stacks[names.join(';')];
+			}
+
+			QFile file(filename);
+			if (!file.open(QFile::WriteOnly|QFile::Text)) return;
+			for (auto it=stacks.cbegin(); it!=stacks.cend(); ++it)
+			{
+				file.write(it.key() + " " + QByteArray::number(it.value()) + "\n");
+			}
+#else
+			Q_UNUSED(filename);
+#endif
+		}
+
+	protected:
+		static constexpr int frequency = 99; //samples per second of CPU time
+		static constexpr int max_samples = 20000;
+		static constexpr int max_depth = 48;
+
+		struct Sample
+		{
+			int depth;
+			void* frames[max_depth];
+		};
+
+		static Sample* samples()
+		{
+			static std::vector<Sample> samples(max_samples);
+			return samples.data();
+		}
+
+		static std::atomic<int>& sampleCount()
+		{
+			static std::atomic<int> count(0);
+			return count;
+		}
+
+#ifdef Q_OS_LINUX
+		static void handleSignal(int)
+		{
+			int saved_errno = errno;
+			int i = sampleCount()++;
+			if (i<max_samples)
+			{
+				samples()[i].depth = backtrace(samples()[i].frames, max_depth);
+			}
+			errno = saved_errno;
+		}
+
+		//Converts the addresses of the samples to (demangled) function names
+		static QHash<void*, QByteArray> symbolize(int count)
+		{
+			QSet<void*> unique;
+			for (int i=0; i<count; ++i)
+			{
+				for (int j=0; j<samples()[i].depth; ++j)
+				{
+					unique << samples()[i].frames[j];
+				}
+			}
+			std::vector<void*> addresses(unique.begin(), unique.end());
+
+			QHash<void*, QByteArray> output;
+			if (addresses.empty()) return output;
+			char** symbols = backtrace_symbols(addresses.data(), addresses.size());
+			for (size_t i=0; i<addresses.size(); ++i)
+			{
+				//format: 'binary(mangled_name+offset) [address]' or 'binary(+offset) [address]'
+				QByteArray symbol = symbols!=nullptr ? QByteArray(symbols[i]) : QByteArray::number((qulonglong)addresses[i], 16);
+				int open = symbol.indexOf('(');
+				int plus = symbol.indexOf('+', open);
+				int close = symbol.indexOf(')', open);
+				QByteArray name;
+				if (open!=-1 && plus>open+1)
+				{
+					QByteArray mangled = symbol.mid(open+1, plus-open-1);
+					int status = 0;
+					char* demangled = abi::__cxa_demangle(mangled.constData(), nullptr, nullptr, &status);
+					name = status==0 && demangled!=nullptr ? QByteArray(demangled) : mangled;
+					free(demangled);
+				}
+				else if (open!=-1 && close>open)
+				{
+					name = QFileInfo(symbol.left(open)).fileName().toUtf8() + symbol.mid(open+1, close-open-1);
+				}
+				else
+				{
+					name = symbol;
+				}
+				output[addresses[i]] = name.replace(';', ':');
+			}
+			free(symbols);
+			return output;
+		}
+#endif
+	};
+
+	///Result of a test method execution
+	struct TestResult
+	{
+		QByteArray name; //'class::method'
+		QByteArray result; //'PASS', 'SKIP' or 'FAIL!'
+		QByteArray message;
+		int elapsed_ms = 0;
+		QStringList dependencies;
+		QByteArray tool_usage; //resource usage summary of executed tools (empty if no tools were executed or not available)
+		QByteArray counters; //hardware performance counters (empty if not enabled)
+		QByteArray allocations; //heap allocations of the test method (empty if the allocation hook is not installed)
+
+		///Serializes the result to a single line (used to transfer results from worker processes)
+		QByteArray toLine() const
+		{
+			return "TFW_RESULT\t" + name + "\t" + result + "\t" + QByteArray::number(elapsed_ms) + "\t" + message.toBase64() + "\t" + dependencies.join('\n').toUtf8().toBase64() + "\t" + tool_usage.toBase64() + "\t" + counters.toBase64() + "\t" + allocations.toBase64() + "\n";
+		}
+
+		///Parses a line created by toLine(). Returns 'false' if the line is not a result line.
+		bool fromLine(QByteArray line)
+		{
+			while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+			QList<QByteArray> parts = line.split('\t');
+			if (parts.count()!=9 || parts[0]!="TFW_RESULT") return false;
+
+			name = parts[1];
+			result = parts[2];
+			elapsed_ms = parts[3].toInt();
+			message = QByteArray::fromBase64(parts[4]);
+			dependencies = QString::fromUtf8(QByteArray::fromBase64(parts[5])).split('\n');
+			dependencies.removeAll("");
+			tool_usage = QByteArray::fromBase64(parts[6]);
+			counters = QByteArray::fromBase64(parts[7]);
+			allocations = QByteArray::fromBase64(parts[8]);
+			return true;
+		}
+	};
+
+	///Result counts of a test run
+	struct TestSummary
+	{
+		int passed = 0;
+		int skipped = 0;
+		int failed = 0;
+	};
+
+	///Callback for results of test methods
+	typedef std::function<void(const TestResult&)> ResultHandler;
+
+	///Cache of passed test methods for incremental test runs.
+	///A result is valid as long as the content of the test executable, the executed tools and the used test data files is unchanged.
+	class ResultCache
+	{
+	public:
+		ResultCache(QString filename)
+			: filename_(filename)
+		{
+			QFile file(filename_);
+			if (!file.open(QFile::ReadOnly|QFile::Text)) return;
+			while(!file.atEnd())
+			{
+				QList<QByteArray> parts = file.readLine().trimmed().split('\t');
+				if (parts.count()<3 || parts.count()%2!=1) continue;
+
+				QList<QPair<QString, QByteArray>>& hashes = entries_[parts[0]];
+				for (int i=1; i<parts.count(); i+=2)
+				{
+					hashes << qMakePair(QString::fromUtf8(parts[i]), parts[i+1]);
+				}
+			}
+		}
+
+		///Returns if a cached PASS result exists and all dependencies are unchanged
+		bool isUpToDate(const QByteArray& test_name)
+		{
+			if (!entries_.contains(test_name)) return false;
+			typedef QPair<QString, QByteArray> Entry;
+			foreach(const Entry& entry, entries_[test_name])
+			{
+				if (hash(entry.first)!=entry.second) return false;
+			}
+			return true;
+		}
+
+		///Updates the cache with a test result (only PASS results are cached)
+		void update(const TestResult& result)
+		{
+			entries_.remove(result.name);
+			if (result.result!="PASS") return;
+
+			QStringList files = result.dependencies;
+			files << QCoreApplication::applicationFilePath();
+			files << sharedLibraries();
+			files.removeDuplicates();
+			QList<QPair<QString, QByteArray>>& hashes = entries_[result.name];
+			foreach(const QString& file, files)
+			{
+				hashes << qMakePair(file, hash(file));
+			}
+		}
+
+		///Writes the cache to disk
+		void store()
+		{
+			QSaveFile file(filename_);
+			if (!file.open(QFile::WriteOnly|QFile::Text)) return;
+			typedef QPair<QString, QByteArray> Entry;
+			for (auto it=entries_.cbegin(); it!=entries_.cend(); ++it)
+			{
+				QByteArray line = it.key();
+				foreach(const Entry& entry, it.value())
+				{
+					line += "\t" + entry.first.toUtf8() + "\t" + entry.second;
+				}
+				file.write(line + "\n");
+			}
+			file.commit();
+		}
+
+	protected:
+		//Returns the shared libraries loaded by the test executable and the shared libraries in its folder, which can be used by the tools
+		const QStringList& sharedLibraries()
+		{
+			if (libraries_.isEmpty())
+			{
+#ifdef Q_OS_LINUX
+				QFile maps("/proc/self/maps");
+				if (maps.open(QFile::ReadOnly|QFile::Text))
+				{
+					foreach(const QByteArray& line, maps.readAll().split('\n'))
+					{
+						int pos = line.indexOf('/');
+						if (pos==-1) continue;
+						QString path = QString::fromUtf8(line.mid(pos).trimmed());
+						if (path.endsWith(".so") || path.contains(".so.")) libraries_ << path;
+					}
+				}
+#endif
+				QDir dir(QCoreApplication::applicationDirPath());
+				foreach(const QFileInfo& info, dir.entryInfoList(QStringList() << "*.so" << "*.so.*" << "*.dll" << "*.dylib", QDir::Files))
+				{
+					libraries_ << info.absoluteFilePath();
+				}
+				libraries_.removeDuplicates();
+			}
+			return libraries_;
+		}
+
+		//Returns the content hash of a file (each file is hashed only once per run)
+		QByteArray hash(const QString& filename)
+		{
+			if (!hashes_.contains(filename))
+			{
+				QByteArray hash = "missing";
+				QFile file(filename);
+				if (file.open(QFile::ReadOnly))
+				{
+					QCryptographicHash hasher(QCryptographicHash::Sha1);
+					hasher.addData(&file);
+					hash = hasher.result().toHex();
+				}
+				hashes_[filename] = hash;
+			}
+			return hashes_[filename];
+		}
+
+		QString filename_;
+		QHash<QByteArray, QList<QPair<QString, QByteArray>>> entries_;
+		QHash<QString, QByteArray> hashes_;
+		QStringList libraries_;
+	};
+
+	///Duration history of test methods, stored in an append-only file. Only the last 'history' durations of each method are used.
+	class TimingDatabase
+	{
+	public:
+		TimingDatabase(QString filename, int history = 10)
+			: filename_(filename)
+			, history_(history)
+			, line_count_(0)
+		{
+			QFile file(filename_);
+			if (!file.open(QFile::ReadOnly|QFile::Text)) return;
+			while(!file.atEnd())
+			{
+				QList<QByteArray> parts = file.readLine().trimmed().split('\t');
+				if (parts.count()!=2) continue;
+
+				QList<int>& durations = durations_[parts[0]];
+				durations << parts[1].toInt();
+				if (durations.count()>history_) durations.removeFirst();
+				++line_count_;
+			}
+		}
+
+		///Returns the median of the recorded durations in ms, or -1 if the test method has no history
+		int median(const QByteArray& test_name) const
+		{
+			if (!durations_.contains(test_name)) return -1;
+			QList<int> durations = durations_[test_name];
+			std::sort(durations.begin(), durations.end());
+			int n = durations.count();
+			return n%2==1 ? durations[n/2] : (durations[n/2-1] + durations[n/2]) / 2;
+		}
+
+		///Returns the number of recorded durations of a test method
+		int count(const QByteArray& test_name) const
+		{
+			return durations_.value(test_name).count();
+		}
+
+		///Adds the duration of a passed test method (written to disk by store())
+		void add(const TestResult& result)
+		{
+			if (result.result!="PASS") return;
+			added_ << qMakePair(result.name, result.elapsed_ms);
+		}
+
+		///Appends the added durations to the file. If the file contains too many outdated entries, it is compacted.
+		void store()
+		{
+			typedef QPair<QByteArray, int> Entry;
+			foreach(const Entry& entry, added_)
+			{
+				QList<int>& durations = durations_[entry.first];
+				durations << entry.second;
+				if (durations.count()>history_) durations.removeFirst();
+			}
+
+			line_count_ += added_.count();
+			if (line_count_ > 2 * history_ * durations_.count())
+			{
+				QSaveFile file(filename_);
+				if (!file.open(QFile::WriteOnly|QFile::Text)) return;
+				for (auto it=durations_.cbegin(); it!=durations_.cend(); ++it)
+				{
+					foreach(int duration, it.value())
+					{
+						file.write(it.key() + "\t" + QByteArray::number(duration) + "\n");
+					}
+				}
+				file.commit();
+				line_count_ = 0;
+				foreach(const QList<int>& durations, durations_) line_count_ += durations.count();
+			}
+			else
+			{
+				QFile file(filename_);
+				if (!file.open(QFile::Append|QFile::Text)) return;
+				foreach(const Entry& entry, added_)
+				{
+					file.write(entry.first + "\t" + QByteArray::number(entry.second) + "\n");
+				}
+			}
+			added_.clear();
+		}
+
+	protected:
+		QString filename_;
+		int history_;
+		int line_count_;
+		QHash<QByteArray, QList<int>> durations_;
+		QList<QPair<QByteArray, int>> added_;
+	};
+
+	///Orders test methods by expected duration for parallel execution: longest first, methods without recorded duration are treated as longest.
+	///Returns the predicted makespan in ms when executing on 'slots' parallel executors, or -1 if no durations are recorded.
+	inline int scheduleLongestFirst(QList<TestCase>& test_cases, const TimingDatabase& timings, int slots)
+	{
+		QHash<QByteArray, int> expected;
+		int max_known = -1;
+		foreach(const TestCase& test_case, test_cases)
+		{
+			int median = timings.median(test_case.name);
+			expected[test_case.name] = median;
+			max_known = std::max(max_known, median);
+		}
+
+		std::stable_sort(test_cases.begin(), test_cases.end(), [&](const TestCase& a, const TestCase& b)
+		{
+			int a_ms = expected[a.name];
+			int b_ms = expected[b.name];
+			if (a_ms==-1) return b_ms!=-1;
+			if (b_ms==-1) return false;
+			return a_ms > b_ms;
+		});
+		if (max_known==-1) return -1;
+
+		//simulate execution: each test method runs on the executor that is idle first
+		std::vector<qint64> finished(std::max(1, slots), 0);
+		foreach(const TestCase& test_case, test_cases)
+		{
+			int duration = expected[test_case.name];
+			if (duration==-1) duration = max_known;
+			*std::min_element(finished.begin(), finished.end()) += duration;
+		}
+		return *std::max_element(finished.begin(), finished.end());
+	}
+
+	///Returns the test methods of shard 'index' (0-based) of 'count' shards. The assignment only depends on the test names (and the timing file), so it is identical on all nodes.
+	///If a timing file is given, methods with recorded duration are distributed greedily to the least-loaded shard (longest first). Other methods are assigned by a hash of their name.
+	inline QList<TestCase> selectShard(const QList<TestCase>& test_cases, int index, int count, QString timing_file)
+	{
+		QHash<QByteArray, int> shard_of_test;
+
+		//duration-balanced assignment
+		if (!timing_file.isEmpty())
+		{
+			TimingDatabase timings(timing_file);
+			QList<QPair<int, QByteArray>> known;
+			foreach(const TestCase& test_case, test_cases)
+			{
+				int median = timings.median(test_case.name);
+				if (median!=-1) known << qMakePair(median, test_case.name);
+			}
+			std::sort(known.begin(), known.end(), [](const QPair<int, QByteArray>& a, const QPair<int, QByteArray>& b)
+			{
+				if (a.first!=b.first) return a.first > b.first;
+				return a.second < b.second;
+			});
+
+			std::vector<qint64> load(count, 0);
+			typedef QPair<int, QByteArray> Entry;
+			foreach(const Entry& entry, known)
+			{
+				int shard = std::min_element(load.begin(), load.end()) - load.begin();
+				load[shard] += entry.first;
+				shard_of_test[entry.second] = shard;
+			}
+		}
+
+		//hash-based assignment
+		QList<TestCase> output;
+		foreach(const TestCase& test_case, test_cases)
+		{
+			int shard;
+			if (shard_of_test.contains(test_case.name))
+			{
+				shard = shard_of_test[test_case.name];
+			}
+			else
+			{
+				QByteArray hash = QCryptographicHash::hash(test_case.name, QCryptographicHash::Md5);
+				quint32 value = (quint8)hash[0] << 24 | (quint8)hash[1] << 16 | (quint8)hash[2] << 8 | (quint8)hash[3];
+				shard = value % count;
+			}
+			if (shard==index) output << test_case;
+		}
+		return output;
+	}
+
+	///Returns the test methods that pass the string and list filter
+	inline QList<TestCase> selectTests(QByteArray s_filter, QStringList l_filter)
+	{
+		QList<TestCase> output;
+		foreach (TestClass* test, testClasses())
+		{
+			foreach (const QByteArray& method, testMethods().value(test->key()))
+			{
+				QByteArray test_and_method = test->name() + "::" + method;
+
+				//string filter
+				if (!test_and_method.contains(s_filter))
+				{
+					continue;
+				}
+
+				//test list filter
+				if (!l_filter.isEmpty())
+				{
+					bool found = false;
+					foreach(QString filter, l_filter)
+					{
+						if (test_and_method+"()"==filter || test_and_method==filter)
+						{
+							found = true;
+						}
+					}
+					if (!found) continue;
+				}
+
+				output << TestCase{test, method, test_and_method, testTimeouts().value(test->key()).value(method, defaultTimeout()), testResources().value(test->key()), testMemory().value(test->key(), 0)};
+			}
+		}
+		return output;
+	}
+
+	///Deletes output files of previous test runs, i.e. files starting with the name of a test class (without '_Test'). The folder is scanned only once.
+	inline void removeOldOutputFiles(QString folder = "out")
+	{
+		QByteArrayList prefixes;
+		foreach (TestClass* test, testClasses())
+		{
+			QByteArray test_name = test->name();
+			prefixes << test_name.left(test_name.length()-5);
+		}
+
+		QDir dir(folder);
+		foreach(const QString& filename, dir.entryList(QDir::Files))
+		{
+			QByteArray name = filename.toUtf8();
+			foreach(const QByteArray& prefix, prefixes)
+			{
+				if (name.startsWith(prefix) && name.indexOf('.', prefix.length())!=-1)
+				{
+					dir.remove(filename);
+					break;
+				}
+			}
+		}
+	}
+
+	//Copies the state files of the framework (timing history, incremental cache, benchmark results) from one folder to another
+	inline void copyStateFiles(QString from, QString to)
+	{
+		foreach(const QString& filename, QDir(from).entryList(QStringList() << "tfw_*", QDir::Files))
+		{
+			QFile::remove(to + "/" + filename);
+			QFile::copy(from + "/" + filename, to + "/" + filename);
+		}
+	}
+
+	///Folder the disk output folder 'out' is renamed to while 'out' is a link to a RAM output folder (see --ram-out)
+	inline QString diskOutputFolder()
+	{
+		return "out_tfw_disk";
+	}
+
+	///If 'out' is a link to a RAM output folder of a previous run, it is replaced by the disk output folder again. The state files are copied from the RAM output folder, which is deleted.
+	inline void restoreDiskOutputFolder()
+	{
+		QFileInfo out_info("out");
+		if (!out_info.isSymLink()) return;
+
+		QString target = out_info.symLinkTarget();
+		QFile::remove("out");
+		if (!QDir(".").rename(diskOutputFolder(), "out")) QDir(".").mkdir("out");
+		copyStateFiles(target, "out");
+		if (target.startsWith("/dev/shm/tfw_out_")) QDir(target).removeRecursively();
+	}
+
+	///Replaces the folder 'out' by a symbolic link to a new folder in RAM (see --ram-out). Returns the path of the new folder, or an empty string on error.
+	///Output files of previous runs of this test executable are deleted. The folder 'out' is renamed (not copied), so that the output of other test executables is kept on disk. Only the state files are copied to the new folder.
+	inline QString createRamOutputFolder()
+	{
+#ifdef Q_OS_LINUX
+		restoreDiskOutputFolder();
+		QDir(".").mkdir("out");
+		removeOldOutputFiles();
+
+		QByteArray path = "/dev/shm/tfw_out_XXXXXX";
+		if (mkdtemp(path.data())==nullptr)
+		{
+			qDebug() << "Could not create RAM output folder:" << strerror(errno);
+			return "";
+		}
+		if (QFileInfo::exists(diskOutputFolder()) || !QDir(".").rename("out", diskOutputFolder()))
+		{
+			qDebug() << "Could not rename folder 'out' to" << diskOutputFolder();
+			QDir(path).removeRecursively();
+			return "";
+		}
+		copyStateFiles(diskOutputFolder(), path);
+
+		if (!QFile::link(path, "out"))
+		{
+			qDebug() << "Could not create symbolic link 'out' to RAM output folder" << path;
+			QDir(".").rename(diskOutputFolder(), "out");
+			QDir(path).removeRecursively();
+			return "";
+		}
+		return path;
+#else
+		qDebug() << "RAM output folder is not available on this platform!";
+		return "";
+#endif
+	}
+
+	///Executes a test method and returns the result
+	inline TestResult runTest(const TestCase& test_case, bool debug_output, QFile& outstream)
+	{
+		//execute test
+		context() = TestContext();
+		if (test_case.timeout>0)
+		{
+			context().timeout = test_case.timeout;
+			context().deadline.setRemainingTime((qint64)test_case.timeout * 1000);
+		}
+		PerfCounters counters;
+		bool counters_open = PerfCounters::enabled() && counters.open().isEmpty();
+		QElapsedTimer timer;
+		timer.start();
+		if (counters_open) counters.start();
+		if (SamplingProfiler::enabled()) SamplingProfiler::start();
+		AllocCounters& alloc_counters = allocCounters();
+		AllocCounters alloc_start = alloc_counters;
+		alloc_counters.peak_live_bytes = alloc_counters.live_bytes;
+		try
+		{
+			if (debug_output)
+			{
+				QMutexLocker locker(&outputMutex());
+				outstream.write("Performing " + test_case.test->name() + ":" + test_case.method + "\n");
+				outstream.flush();
+			}
+
+			//class setup: a failure is reported by the first test method, the others are skipped
+			test_case.test->prepare();
+			context().dependencies << test_case.test->setupDependencies();
+			if (test_case.test->setupResult()=="FAIL!")
+			{
+				if (test_case.test->reportSetupFailure())
+				{
+					failed() = true;
+					message() = "class setup failed:\n" + test_case.test->setupMessage();
+				}
+				else
+				{
+					skipped() = true;
+					message() = "skipped because class setup failed";
+				}
+			}
+			else if (test_case.test->setupResult()=="SKIP")
+			{
+				skipped() = true;
+				message() = test_case.test->setupMessage();
+			}
+			else
+			{
+				test_case.test->method(test_case.method)();
+			}
+		}
+		catch (TestSkipped& e)
+		{
+			message() = e.message;
+			skipped() = true;
+		}
+		catch (...)
+		{
+			message() = currentExceptionMessage();
+			failed() = true;
+		}
+
+		//kill asynchronous tools that were not waited for
+		foreach(const std::shared_ptr<ToolCall>& call, context().tool_calls)
+		{
+			abortTool(*call);
+		}
+		QByteArray counter_values;
+		if (counters_open) counter_values = counters.stop();
+		AllocCounters alloc_end = alloc_counters;
+
+		//evaluate what happened
+		TestResult output;
+		output.name = test_case.name;
+		output.message = message();
+		output.elapsed_ms = timer.elapsed();
+		output.dependencies = context().dependencies;
+		output.dependencies.removeDuplicates();
+		if (context().tool_usage.valid) output.tool_usage = "tools: " + context().tool_usage.toString();
+		output.counters = counter_values;
+		if (allocHookInstalled())
+		{
+			output.allocations = QByteArray::number(alloc_end.allocations-alloc_start.allocations) + " (" + QByteArray::number((alloc_end.bytes-alloc_start.bytes)/1048576.0, 'f', 2) + " MB)"
+							   + ", peak live " + QByteArray::number((alloc_end.peak_live_bytes-alloc_start.live_bytes)/1048576.0, 'f', 2) + " MB";
+		}
+		if (SamplingProfiler::enabled()) SamplingProfiler::stop("out/" + test_case.test->name() + "_" + test_case.method + ".folded");
+		if (failed())
+		{
+			output.result = "FAIL!";
+		}
+		else if(skipped())
+		{
+			output.result = "SKIP";
+		}
+		else
+		{
+			output.result = "PASS";
+		}
+		return output;
+	}
+
+	///Writes the result line of a test method and updates the summary counts
+	inline void writeResult(QFile& outstream, const TestResult& result, TestSummary& summary)
+	{
+		if (result.result=="FAIL!") ++summary.failed;
+		else if (result.result=="SKIP") ++summary.skipped;
+		else ++summary.passed;
+
+		QByteArray line = result.result + "\t" + result.name + "()\t" + Helper::elapsedTime(result.elapsed_ms, true);
+		if (!result.tool_usage.isEmpty()) line += "\t" + result.tool_usage;
+		if (!result.counters.isEmpty()) line += "\tcounters: " + result.counters;
+		if (!result.allocations.isEmpty()) line += "\tallocations: " + result.allocations;
+		outstream.write(line + "\n");
+		if (!result.message.isEmpty())
+		{
+			QList<QByteArray> parts = result.message.trimmed().split('\n');
+			foreach(QByteArray part, parts)
+			{
+				outstream.write("  " + part.trimmed() + "\n");
+			}
+		}
+		outstream.flush();
+	}
+
+	///Queue of test cases for parallel execution. Test cases are handed out in order, but only if the resources they use (see USES_RESOURCE and MEMORY_MB) are available.
+	///If no test case is running, the next one is always handed out, so that test cases that use more than the capacity do not block the queue.
+	///Test methods of classes with setup/teardown are all handed out to the process that took the first of them (see 'slot' in take()), so that setup and teardown are executed once per run.
+	class TestQueue
+	{
+	public:
+		TestQueue(const QList<TestCase>& test_cases, bool limit_memory = true)
+			: test_cases_(test_cases)
+			, limit_memory_(limit_memory)
+			, running_(0)
+			, memory_used_(0)
+		{
+			for (int i=0; i<test_cases.count(); ++i)
+			{
+				pending_ << i;
+			}
+		}
+
+		///Capacity of resources (see --resource), resources that are not contained have a capacity of 1
+		static QHash<QByteArray, int>& capacities()
+		{
+			static QHash<QByteArray, int> capacities;
+			return capacities;
+		}
+
+		///Memory capacity in MB (see --memory-mb), 0 means unlimited. The default is the physical memory.
+		static qint64& memoryCapacity()
+		{
+#ifdef Q_OS_LINUX
+			static qint64 memory = (qint64)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE) / 1048576;
+#else
+			static qint64 memory = 0;
+#endif
+			return memory;
+		}
+
+		///Returns if there are test cases that were not handed out yet
+		bool isEmpty() const
+		{
+			return pending_.isEmpty();
+		}
+
+		///Returns the index of the next test case whose resources are available and marks them as used, or -1 if there is none.
+		///'slot' identifies the worker process the test case is executed in (-1 if all test cases are executed in this process).
+		int take(int slot = -1)
+		{
+			for (int i=0; i<pending_.count(); ++i)
+			{
+				const TestCase& test_case = test_cases_[pending_[i]];
+				bool pinned = slot!=-1 && classesWithSetup().contains(test_case.test->key());
+				if (pinned && owners_.value(test_case.test->key(), slot)!=slot) continue;
+				if (running_>0 && !fits(test_case)) continue;
+				if (pinned) owners_[test_case.test->key()] = slot;
+
+				for (auto it=test_case.resources.cbegin(); it!=test_case.resources.cend(); ++it)
+				{
+					used_[it.key()] += it.value();
+				}
+				memory_used_ += test_case.memory_mb;
+				++running_;
+				return pending_.takeAt(i);
+			}
+			return -1;
+		}
+
+		///Releases the resources of a test case returned by take()
+		void release(int index)
+		{
+			const TestCase& test_case = test_cases_[index];
+			for (auto it=test_case.resources.cbegin(); it!=test_case.resources.cend(); ++it)
+			{
+				used_[it.key()] -= it.value();
+			}
+			memory_used_ -= test_case.memory_mb;
+			--running_;
+		}
+
+		///Releases a test case returned by take() and hands it out again
+		void requeue(int index)
+		{
+			release(index);
+			pending_.prepend(index);
+		}
+
+		///Releases the test classes pinned to a worker process (e.g. when it terminated)
+		void releaseSlot(int slot)
+		{
+			for (auto it=owners_.begin(); it!=owners_.end();)
+			{
+				if (it.value()==slot) it = owners_.erase(it);
+				else ++it;
+			}
+		}
+
+	protected:
+		bool fits(const TestCase& test_case) const
+		{
+			for (auto it=test_case.resources.cbegin(); it!=test_case.resources.cend(); ++it)
+			{
+				if (used_.value(it.key(), 0) + it.value() > capacities().value(it.key(), 1)) return false;
+			}
+			return !limit_memory_ || memoryCapacity()<=0 || memory_used_ + test_case.memory_mb <= memoryCapacity();
+		}
+
+		const QList<TestCase>& test_cases_;
+		bool limit_memory_;
+		QList<int> pending_;
+		QHash<const void*, int> owners_; //test class > slot it is pinned to
+		QHash<QByteArray, int> used_;
+		int running_;
+		qint64 memory_used_;
+	};
+
+	///Worker main loop: reads test names from 'input', executes them and writes the results to 'output'.
+	///Input/output are stdin/stdout for worker processes (-j) or the connection to the coordinator (--worker). Debug output is written to 'outstream'.
+	inline int runWorker(QIODevice& input, QIODevice& output, QFile& outstream, bool debug_output)
+	{
+		QHash<QByteArray, TestCase> tests;
+		foreach(const TestCase& test_case, selectTests("", QStringList()))
+		{
+			tests[test_case.name] = test_case;
+		}
+
+		while(true)
+		{
+			while (!input.canReadLine() && input.waitForReadyRead(-1)) {} //sockets only - returns 'false' immediately for files
+			QByteArray test_name = input.readLine().trimmed();
+			if (test_name.isEmpty()) break;
+
+			TestResult result;
+			if (tests.contains(test_name))
+			{
+				result = runTest(tests[test_name], debug_output, outstream);
+			}
+			else
+			{
+				result.name = test_name;
+				result.result = "FAIL!";
+				result.message = "Test method not found in worker process!";
+			}
+			output.write(result.toLine());
+			outstream.flush();
+			output.waitForBytesWritten(-1);
+		}
+
+		teardownClasses(outstream);
+		return 0;
+	}
+
+	///Executes the test methods in 'jobs' worker processes
+	inline void runInWorkers(const QList<TestCase>& test_cases, int jobs, QStringList args, QFile& outstream, ResultHandler handle_result)
+	{
+		args << "--worker-pipe";
+
+		struct Worker
+		{
+			QProcess* process;
+			int current; //index of running test case or -1
+			QByteArray buffer;
+			QTimer* watchdog; //kills the worker when the timeout of the running test case expires
+			bool timed_out;
+			QByteArray diagnostics; //output of the worker after the watchdog requested a backtrace
+			int slot; //identifies the worker in the queue
+		};
+		QList<Worker*> workers;
+		const int grace_ms = 2000; //the worker kills tools itself when the timeout expires, so give it some time to report the result
+
+		QEventLoop loop;
+		TestQueue queue(test_cases);
+		int done = 0;
+
+		//starts the next test case on an idle worker (workers stay idle if the resources of the remaining test cases are in use)
+		auto dispatch = [&](Worker* worker)
+		{
+			worker->current = -1;
+			if (queue.isEmpty())
+			{
+				worker->process->closeWriteChannel();
+				return;
+			}
+			int index = queue.take(worker->slot);
+			if (index==-1) return;
+			worker->current = index;
+			worker->process->write(test_cases[worker->current].name + "\n");
+			int timeout = test_cases[worker->current].timeout;
+			if (timeout>0) worker->watchdog->start(timeout*1000 + grace_ms);
+			else worker->watchdog->stop();
+		};
+
+		//starts test cases on idle workers after resources were released
+		auto dispatchIdle = [&]()
+		{
+			foreach(Worker* worker, workers)
+			{
+				if (worker->current==-1 && !worker->timed_out && worker->process->state()==QProcess::Running) dispatch(worker);
+			}
+		};
+
+		//creates a worker process (also used to replace crashed workers)
+		std::function<void()> startWorker;
+		startWorker = [&]()
+		{
+			Worker* worker = new Worker{new QProcess(), -1, QByteArray(), new QTimer(), false, QByteArray(), workers.count()};
+			workers << worker;
+			worker->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+			worker->watchdog->setSingleShot(true);
+
+			//watchdog: request a backtrace, kill the worker if it does not terminate
+			QObject::connect(worker->watchdog, &QTimer::timeout, [&, worker]()
+			{
+				if (worker->timed_out)
+				{
+					worker->process->kill();
+					return;
+				}
+				worker->timed_out = true;
+#ifdef Q_OS_LINUX
+				kill(worker->process->processId(), SIGUSR2);
+				worker->watchdog->start(grace_ms);
+#else
+				worker->process->kill();
+#endif
+			});
+
+			QObject::connect(worker->process, &QProcess::readyReadStandardOutput, [&, worker]()
+			{
+				worker->buffer += worker->process->readAllStandardOutput();
+				int pos;
+				while ((pos = worker->buffer.indexOf('\n'))!=-1)
+				{
+					QByteArray line = worker->buffer.left(pos+1);
+					worker->buffer.remove(0, pos+1);
+
+					TestResult result;
+					if (result.fromLine(line))
+					{
+						handle_result(result);
+						++done;
+						queue.release(worker->current);
+						if (worker->timed_out) //result arrived after the backtrace was requested: the worker terminates anyway
+						{
+							worker->current = -1;
+							worker->watchdog->stop();
+						}
+						else
+						{
+							dispatch(worker);
+						}
+						dispatchIdle();
+					}
+					else if (worker->timed_out) //backtrace of the hanging test
+					{
+						worker->diagnostics += line;
+					}
+					else //forward output of tests, e.g. debug output
+					{
+						QMutexLocker locker(&outputMutex());
+						outstream.write(line);
+						outstream.flush();
+					}
+				}
+				if (done==test_cases.count()) loop.quit();
+			});
+
+			QObject::connect(worker->process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), [&, worker](int exit_code, QProcess::ExitStatus status)
+			{
+				worker->watchdog->stop();
+				queue.releaseSlot(worker->slot);
+				if (worker->current==-1)
+				{
+					if (worker->timed_out && !queue.isEmpty()) startWorker();
+					dispatchIdle();
+					return;
+				}
+
+				//report running test as failed
+				TestResult result;
+				result.name = test_cases[worker->current].name;
+				result.result = "FAIL!";
+				if (worker->timed_out)
+				{
+					worker->diagnostics += worker->buffer + worker->process->readAllStandardOutput();
+					result.elapsed_ms = test_cases[worker->current].timeout * 1000;
+					result.message = timeoutMessage(test_cases[worker->current].timeout, worker->diagnostics);
+				}
+				else
+				{
+					result.message = "worker process terminated unexpectedly (" + (status==QProcess::CrashExit ? QByteArray("crash") : "exit code " + QByteArray::number(exit_code)) + ")";
+				}
+				handle_result(result);
+				queue.release(worker->current);
+				worker->current = -1;
+				++done;
+
+				if (done==test_cases.count()) loop.quit();
+				else if (!queue.isEmpty()) startWorker();
+				dispatchIdle();
+			});
+
+			worker->process->start(QCoreApplication::applicationFilePath(), args);
+			if (!worker->process->waitForStarted(-1)) THROW(ProgrammingException, "Could not start worker process: " + worker->process->errorString());
+			dispatch(worker);
+		};
+
+		if (test_cases.isEmpty()) return;
+		for (int i=0; i<std::min(jobs, (int)test_cases.count()); ++i)
+		{
+			startWorker();
+		}
+		loop.exec();
+
+		//clean up
+		foreach(Worker* worker, workers)
+		{
+			worker->process->closeWriteChannel();
+			worker->process->waitForFinished(-1);
+			delete worker->process;
+			delete worker->watchdog;
+			delete worker;
+		}
+	}
+
+#ifdef QT_NETWORK_LIB
+	///Serves the test methods to workers connecting via TCP (see --worker) until all results are received. Returns 'false' if the port cannot be opened.
+	///Test methods of workers that disconnect before sending the result are handed out again (once).
+	///Workers are not authenticated, so 'address' should only be a public interface in a trusted network (see --coordinator-bind).
+	inline bool runCoordinator(const QList<TestCase>& test_cases, QString address, quint16 port, QFile& outstream, ResultHandler handle_result)
+	{
+		QHostAddress host_address;
+		if (!host_address.setAddress(address))
+		{
+			qDebug() << "Invalid coordinator bind address" << address;
+			return false;
+		}
+		QTcpServer server;
+		if (!server.listen(host_address, port))
+		{
+			qDebug() << "Could not listen on" << address << "port" << port << ":" << server.errorString();
+			return false;
+		}
+		if (test_cases.isEmpty()) return true;
+		{
+			QMutexLocker locker(&outputMutex());
+			outstream.write("Waiting for workers on port " + QByteArray::number(server.serverPort()) + "\n");
+			outstream.flush();
+		}
+
+		struct Connection
+		{
+			QTcpSocket* socket;
+			int current; //index of running test case or -1
+			QByteArray buffer;
+			int slot; //identifies the worker in the queue
+		};
+
+		const int max_attempts = 2;
+		TestQueue queue(test_cases, false); //resources are shared by all workers (e.g. a database), but memory is local to the worker machines
+		QVector<int> attempts(test_cases.count(), 0);
+		QList<Connection*> connections;
+		int slot_count = 0;
+		QEventLoop loop;
+		int done = 0;
+
+		//sends the next test case to a worker (idle workers stay connected, test cases of disconnected workers might be handed out again)
+		auto dispatch = [&](Connection* connection)
+		{
+			connection->current = queue.take(connection->slot);
+			if (connection->current==-1) return;
+			++attempts[connection->current];
+			connection->socket->write(test_cases[connection->current].name + "\n");
+		};
+
+		//sends test cases to all idle workers, e.g. when resources were released
+		auto dispatchIdle = [&]()
+		{
+			foreach(Connection* connection, connections)
+			{
+				if (connection->current==-1) dispatch(connection);
+			}
+		};
+
+		QObject::connect(&server, &QTcpServer::newConnection, [&]()
+		{
+			while (server.hasPendingConnections())
+			{
+				Connection* connection = new Connection{server.nextPendingConnection(), -1, QByteArray(), slot_count++};
+				connections << connection;
+
+				QObject::connect(connection->socket, &QTcpSocket::readyRead, [&, connection]()
+				{
+					connection->buffer += connection->socket->readAll();
+					int pos;
+					while ((pos = connection->buffer.indexOf('\n'))!=-1)
+					{
+						QByteArray line = connection->buffer.left(pos+1);
+						connection->buffer.remove(0, pos+1);
+
+						TestResult result;
+						if (connection->current!=-1 && result.fromLine(line))
+						{
+							handle_result(result);
+							++done;
+							queue.release(connection->current);
+							connection->current = -1;
+							dispatchIdle();
+						}
+					}
+					if (done==test_cases.count()) loop.quit();
+				});
+
+				QObject::connect(connection->socket, &QTcpSocket::disconnected, [&, connection]()
+				{
+					queue.releaseSlot(connection->slot);
+					if (connection->current!=-1)
+					{
+						if (attempts[connection->current]<max_attempts) //hand out again
+						{
+							queue.requeue(connection->current);
+						}
+						else //report as failed
+						{
+							queue.release(connection->current);
+							TestResult result;
+							result.name = test_cases[connection->current].name;
+							result.result = "FAIL!";
+							result.message = "worker disconnected during test execution (" + QByteArray::number(max_attempts) + " attempts)";
+							handle_result(result);
+							++done;
+						}
+						connection->current = -1;
+					}
+					connections.removeAll(connection);
+					connection->socket->deleteLater();
+					delete connection;
+
+					//hand out requeued test cases, test classes that were pinned to the worker and test cases waiting for resources
+					dispatchIdle();
+
+					if (done==test_cases.count()) loop.quit();
+				});
+
+				dispatch(connection);
+			}
+		});
+
+		loop.exec();
+
+		//disconnect workers (they terminate when the connection is closed)
+		server.close();
+		foreach(Connection* connection, connections)
+		{
+			QObject::disconnect(connection->socket, nullptr, nullptr, nullptr);
+			connection->socket->disconnectFromHost();
+			if (connection->socket->state()!=QAbstractSocket::UnconnectedState) connection->socket->waitForDisconnected(1000);
+			delete connection;
+		}
+		return true;
+	}
+
+	///Connects to a coordinator (see --coordinator) and executes the test methods it sends. Returns 'false' if no connection could be established.
+	inline bool runNetworkWorker(QString host, quint16 port, bool debug_output)
+	{
+		//retry for a while - workers may be started before the coordinator
+		const int max_attempts = 60;
+		QTcpSocket socket;
+		for (int attempt=0; attempt<max_attempts; ++attempt)
+		{
+			socket.connectToHost(host, port);
+			if (socket.waitForConnected(1000)) break;
+			socket.abort();
+			QThread::sleep(1);
+		}
+		if (socket.state()!=QAbstractSocket::ConnectedState)
+		{
+			qDebug() << "Could not connect to coordinator" << host << port << ":" << socket.errorString();
+			return false;
+		}
+
+		QFile outstream;
+		outstream.open(stdout, QFile::WriteOnly);
+		runWorker(socket, socket, outstream, debug_output);
+		return true;
+	}
+#endif
+
+	///Executes the test methods in 'threads' threads of this process
+	inline void runInThreads(const QList<TestCase>& test_cases, int threads, bool debug_output, QFile& outstream, ResultHandler handle_result)
+	{
+		TestQueue queue(test_cases);
+		std::mutex mutex;
+		std::condition_variable released;
+		std::vector<std::thread> pool;
+		for (int t=0; t<std::min(threads, (int)test_cases.count()); ++t)
+		{
+			pool.emplace_back([&]()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (!queue.isEmpty())
+				{
+					int i = queue.take();
+					if (i==-1) //wait until resources are released
+					{
+						released.wait(lock);
+						continue;
+					}
+					lock.unlock();
+					handle_result(runTest(test_cases[i], debug_output, outstream));
+					lock.lock();
+					queue.release(i);
+					released.notify_all();
+				}
+				released.notify_all();
+			});
+		}
+		for (std::thread& thread : pool)
+		{
+			thread.join();
+		}
+	}
+
+	///Executes each test method in a child process forked from this process, with up to 'jobs' children running at the same time (Linux only).
+	///Global initialization is thus performed only once and crashing test methods do not abort the test run.
+	inline void runInForkedProcesses(const QList<TestCase>& test_cases, int jobs, bool debug_output, QFile& outstream, ResultHandler handle_result)
+	{
+#ifdef Q_OS_LINUX
+		struct Child
+		{
+			pid_t pid;
+			int fd; //read end of the result pipe
+			int index; //index of the test case
+			QByteArray buffer;
+			QDeadlineTimer deadline; //watchdog: SIGUSR2 (backtrace) when the timeout of the test case expires, SIGKILL after the grace period
+			bool timed_out;
+		};
+		std::vector<Child> children;
+		TestQueue queue(test_cases);
+		const int grace_ms = 2000; //the child kills tools itself when the timeout expires, so give it some time to report the result
+
+		//reports a test case that could not be executed properly
+		auto reportFailure = [&](int index, QByteArray message, int elapsed_ms = 0)
+		{
+			TestResult result;
+			result.name = test_cases[index].name;
+			result.result = "FAIL!";
+			result.message = message;
+			result.elapsed_ms = elapsed_ms;
+			handle_result(result);
+		};
+
+		int index;
+		while (!queue.isEmpty() || !children.empty())
+		{
+			//start children (if their resources are available)
+			while ((int)children.size()<jobs && (index = queue.take())!=-1)
+			{
+				//set up the test class in this process, so that it is done only once (children inherit it)
+				bool prepared = true;
+				try
+				{
+					test_cases[index].test->prepare();
+				}
+				catch (...)
+				{
+					prepared = false;
+				}
+				if (!prepared || test_cases[index].test->setupResult()!="PASS") //test method is not executed: no need to fork
+				{
+					handle_result(runTest(test_cases[index], debug_output, outstream));
+					queue.release(index);
+					continue;
+				}
+
+				int fds[2];
+				if (pipe2(fds, O_CLOEXEC)!=0) //tools must not inherit the write end, otherwise the pipe is not closed when the child is killed
+				{
+					queue.release(index);
+					reportFailure(index, "could not create pipe: " + QByteArray(strerror(errno)));
+					continue;
+				}
+				outstream.flush();
+				fflush(nullptr);
+				pid_t pid = fork();
+				if (pid==0) //child: execute test and send result to parent
+				{
+					close(fds[0]);
+					installBacktraceHandler(fds[1]);
+					QByteArray line = runTest(test_cases[index], debug_output, outstream).toLine();
+					writeFd(fds[1], line.constData(), line.size());
+					_exit(0);
+				}
+				close(fds[1]);
+				if (pid==-1)
+				{
+					close(fds[0]);
+					queue.release(index);
+					reportFailure(index, "could not fork test process: " + QByteArray(strerror(errno)));
+					continue;
+				}
+				int timeout = test_cases[index].timeout;
+				QDeadlineTimer deadline(QDeadlineTimer::Forever);
+				if (timeout>0) deadline.setRemainingTime((qint64)timeout*1000 + grace_ms);
+				children.push_back(Child{pid, fds[0], index, QByteArray(), deadline, false});
+			}
+			if (children.empty()) continue;
+
+			//watchdog
+			qint64 poll_timeout = -1;
+			for (Child& child : children)
+			{
+				if (child.deadline.isForever()) continue;
+				if (child.deadline.hasExpired())
+				{
+					if (child.timed_out)
+					{
+						kill(child.pid, SIGKILL);
+						child.deadline = QDeadlineTimer(QDeadlineTimer::Forever);
+						continue;
+					}
+					child.timed_out = true;
+					kill(child.pid, SIGUSR2);
+					child.deadline.setRemainingTime(grace_ms);
+				}
+				qint64 remaining = child.deadline.remainingTime();
+				poll_timeout = poll_timeout==-1 ? remaining : std::min(poll_timeout, remaining);
+			}
+
+			//wait for output of children
+			std::vector<pollfd> poll_fds;
+			for (const Child& child : children)
+			{
+				poll_fds.push_back(pollfd{child.fd, POLLIN, 0});
+			}
+			if (poll(poll_fds.data(), poll_fds.size(), (int)poll_timeout)<=0) continue; //timeout or EINTR
+
+			for (int i=(int)children.size()-1; i>=0; --i)
+			{
+				if (poll_fds[i].revents==0) continue;
+
+				Child& child = children[i];
+				char buffer[4096];
+				ssize_t bytes = read(child.fd, buffer, sizeof(buffer));
+				if (bytes>0)
+				{
+					child.buffer.append(buffer, bytes);
+					continue;
+				}
+				if (bytes==-1 && errno==EINTR) continue;
+
+				//child closed the pipe: collect exit status
+				close(child.fd);
+				int status = 0;
+				while (waitpid(child.pid, &status, 0)==-1 && errno==EINTR) {}
+				queue.release(child.index);
+				TestResult result;
+				if (result.fromLine(child.buffer) && WIFEXITED(status) && WEXITSTATUS(status)==0)
+				{
+					handle_result(result);
+				}
+				else if (child.timed_out)
+				{
+					int timeout = test_cases[child.index].timeout;
+					reportFailure(child.index, timeoutMessage(timeout, child.buffer), timeout*1000);
+				}
+				else if (WIFSIGNALED(status))
+				{
+					reportFailure(child.index, "test process terminated by signal " + QByteArray::number(WTERMSIG(status)) + " (" + QByteArray(strsignal(WTERMSIG(status))) + ")");
+				}
+				else
+				{
+					reportFailure(child.index, "test process exited without result (exit code " + QByteArray::number(WIFEXITED(status) ? WEXITSTATUS(status) : -1) + ")");
+				}
+				children.erase(children.begin() + i);
+			}
+		}
+#else
+		Q_UNUSED(test_cases);
+		Q_UNUSED(jobs);
+		Q_UNUSED(debug_output);
+		Q_UNUSED(outstream);
+		Q_UNUSED(handle_result);
+#endif
+	}
+
+	///Runs the tests. 'global_init' is called once before the tests are executed, e.g. to load settings or indices (in each worker process, but only once with --fork).
+	inline int run(int argc, char *argv[], std::function<void()> global_init = std::function<void()>())
+    {
+		QElapsedTimer timer_startup;
+		timer_startup.start();
+
+		//create an application to be able to use a event loop (e.g. for XML validation) - QApplication only if needed, because it is much slower to create
+		QScopedPointer<QCoreApplication> core_app(needsGui() ? new QApplication(argc, argv) : new QCoreApplication(argc, argv));
+
+		//parse command line parameters
+		QCommandLineParser parser;
+		parser.addOption(QCommandLineOption("s", "Test case string filter for test cases.", "s"));
+		parser.addOption(QCommandLineOption("l", "Test case list to execute.", "l"));
+		parser.addOption(QCommandLineOption("d", "Enable debug output."));
+		parser.addOption(QCommandLineOption("j", "Number of test methods executed in parallel (in worker processes).", "j", "1"));
+		parser.addOption(QCommandLineOption("t", "Number of test methods executed in parallel (in threads).", "t", "1"));
+		parser.addOption(QCommandLineOption("timeout", "Default timeout of test methods in seconds (0 for no timeout). Tools are killed when it expires. With '-j' or '--fork', hanging test methods are killed as well.", "timeout", "0"));
+		parser.addOption(QCommandLineOption("resource", "Capacity of a resource used by tests (see USES_RESOURCE) in the format 'name=N'. Resources without capacity have a capacity of 1. Can be given several times.", "resource"));
+		parser.addOption(QCommandLineOption("memory-mb", "Memory in MB available for tests executed in parallel (see MEMORY_MB). The default is the physical memory.", "memory-mb"));
+		parser.addOption(QCommandLineOption("fork", "Execute each test method in a child process forked after global initialization (Linux only). Use '-j' to execute several in parallel."));
+		parser.addOption(QCommandLineOption("shard", "Execute only the test methods of shard INDEX of COUNT shards (INDEX is 0-based).", "INDEX/COUNT"));
+		parser.addOption(QCommandLineOption("shard-timings", "Timing file used to balance shards by duration (must be identical on all nodes, e.g. a copy of 'out/tfw_timings.tsv').", "shard-timings"));
+		parser.addOption(QCommandLineOption("list", "Print the selected test methods without executing them."));
+		parser.addOption(QCommandLineOption("ram-out", "Create the output folder 'out' as link to a folder in '/dev/shm', which is deleted if all tests pass (Linux only)."));
+		parser.addOption(QCommandLineOption("incremental", "Skip test methods that passed in a previous run, if the test executable, executed tools and test data files are unchanged."));
+		parser.addOption(QCommandLineOption("perf-regressions", "Report test methods that are slower than their median duration of previous runs by more than the given factor.", "perf-regressions"));
+		parser.addOption(QCommandLineOption("bench-warmup", "Number of warmup runs of benchmark methods.", "bench-warmup", QString::number(TestExecutor::benchmarkWarmup())));
+		parser.addOption(QCommandLineOption("bench-iterations", "Number of timed runs of benchmark methods.", "bench-iterations", QString::number(TestExecutor::benchmarkIterations())));
+		parser.addOption(QCommandLineOption("counters", "Measure hardware performance counters of test methods, including executed tools (Linux only)."));
+		parser.addOption(QCommandLineOption("profile", "Sample test methods with a profiler and write folded stacks to 'out/<class>_<method>.folded' (Linux only, not with threads)."));
+		parser.addOption(QCommandLineOption("async-tools", "Maximum number of tools started with EXECUTE_ASYNC that run at the same time (per test method).", "async-tools", QString::number(TestExecutor::maxParallelTools())));
+		parser.addOption(QCommandLineOption("coordinator", "Serve the selected test methods to workers connecting on the given TCP port (see --worker) instead of executing them.", "coordinator"));
+		parser.addOption(QCommandLineOption("coordinator-bind", "Network interface address the coordinator listens on, e.g. '0.0.0.0' for all interfaces (default is '127.0.0.1'). Workers are not authenticated - use other interfaces only in trusted networks.", "coordinator-bind", "127.0.0.1"));
+		parser.addOption(QCommandLineOption("worker", "Execute test methods received from a coordinator (see --coordinator) at 'host:port'.", "worker"));
+		QCommandLineOption worker_option("worker-pipe", "Internal: run as worker process of a parallel test run.");
+		worker_option.setFlags(QCommandLineOption::HiddenFromHelp);
+		parser.addOption(worker_option);
+		parser.addHelpOption();
+		parser.process(*core_app);
+		QByteArray s_filter = parser.value("s").toUtf8();
+		QStringList l_filter;
+		if (parser.value("l")!="")
+		{
+			try
+			{
+				l_filter = Helper::loadTextFile(parser.value("l"), true, '#', true);
+			}
+			catch(Exception e)
+			{
+				qDebug() << "Error loading filter list " << parser.value("l");
+				qDebug() << e.message();
+				return -1;
+			}
+		}
+		bool debug_output = parser.isSet("d");
+		bool incremental = parser.isSet("incremental");
+		int shard_index = 0;
+		int shard_count = 1;
+		if (parser.isSet("shard"))
+		{
+			QStringList parts = parser.value("shard").split('/');
+			bool ok1 = false;
+			bool ok2 = false;
+			if (parts.count()==2)
+			{
+				shard_index = parts[0].toInt(&ok1);
+				shard_count = parts[1].toInt(&ok2);
+			}
+			if (!ok1 || !ok2 || shard_count<1 || shard_index<0 || shard_index>=shard_count)
+			{
+				qDebug() << "Invalid shard " << parser.value("shard") << " - expected INDEX/COUNT with 0 <= INDEX < COUNT";
+				return -1;
+			}
+		}
+		double perf_factor = 0.0;
+		if (parser.isSet("perf-regressions"))
+		{
+			bool ok = false;
+			perf_factor = parser.value("perf-regressions").toDouble(&ok);
+			if (!ok || perf_factor<=1.0)
+			{
+				qDebug() << "Invalid performance regression factor " << parser.value("perf-regressions");
+				return -1;
+			}
+		}
+		int jobs = parser.value("j").toInt();
+		if (jobs<1)
+		{
+			qDebug() << "Invalid number of parallel jobs " << parser.value("j");
+			return -1;
+		}
+		int threads = parser.value("t").toInt();
+		if (threads<1)
+		{
+			qDebug() << "Invalid number of threads " << parser.value("t");
+			return -1;
+		}
+		if (jobs>1 && threads>1)
+		{
+			qDebug() << "Parallel jobs and threads cannot be combined!";
+			return -1;
+		}
+		bool timeout_ok = false;
+		defaultTimeout() = parser.value("timeout").toInt(&timeout_ok);
+		if (!timeout_ok || defaultTimeout()<0)
+		{
+			qDebug() << "Invalid timeout " << parser.value("timeout");
+			return -1;
+		}
+		foreach(const QString& resource, parser.values("resource"))
+		{
+			int sep = resource.indexOf('=');
+			bool ok = false;
+			int capacity = sep>0 ? resource.mid(sep+1).toInt(&ok) : 0;
+			if (!ok || capacity<1)
+			{
+				qDebug() << "Invalid resource capacity " << resource << " - expected name=N with N>0";
+				return -1;
+			}
+			TestQueue::capacities()[resource.left(sep).toUtf8()] = capacity;
+		}
+		if (parser.isSet("memory-mb"))
+		{
+			bool ok = false;
+			TestQueue::memoryCapacity() = parser.value("memory-mb").toLongLong(&ok);
+			if (!ok || TestQueue::memoryCapacity()<1)
+			{
+				qDebug() << "Invalid memory " << parser.value("memory-mb");
+				return -1;
+			}
+		}
+		bool fork_mode = parser.isSet("fork");
+		if (fork_mode)
+		{
+#ifdef Q_OS_LINUX
+			if (threads>1)
+			{
+				qDebug() << "Fork mode cannot be combined with threads!";
+				return -1;
+			}
+#else
+			qDebug() << "Fork mode is not available on this platform!";
+			return -1;
+#endif
+		}
+		quint16 coordinator_port = 0;
+		if (parser.isSet("coordinator"))
+		{
+			bool ok = false;
+			coordinator_port = parser.value("coordinator").toUShort(&ok);
+			if (!ok)
+			{
+				qDebug() << "Invalid coordinator port " << parser.value("coordinator");
+				return -1;
+			}
+			if (jobs>1 || threads>1)
+			{
+				qDebug() << "Coordinator mode cannot be combined with parallel jobs or threads!";
+				return -1;
+			}
+		}
+		QString worker_host;
+		quint16 worker_port = 0;
+		if (parser.isSet("worker"))
+		{
+			int sep = parser.value("worker").lastIndexOf(':');
+			bool ok = false;
+			if (sep>0)
+			{
+				worker_host = parser.value("worker").left(sep);
+				worker_port = parser.value("worker").mid(sep+1).toUShort(&ok);
+			}
+			if (!ok)
+			{
+				qDebug() << "Invalid coordinator address " << parser.value("worker") << " - expected host:port";
+				return -1;
+			}
+		}
+#ifndef QT_NETWORK_LIB
+		if (parser.isSet("coordinator") || parser.isSet("worker"))
+		{
+			qDebug() << "Distributed test execution is not available - the test executable must be linked against QtNetwork ('QT += network')!";
+			return -1;
+		}
+#endif
+		TestExecutor::benchmarkWarmup() = parser.value("bench-warmup").toInt();
+		TestExecutor::benchmarkIterations() = parser.value("bench-iterations").toInt();
+		if (TestExecutor::benchmarkWarmup()<0 || TestExecutor::benchmarkIterations()<1)
+		{
+			qDebug() << "Invalid number of benchmark warmup runs/iterations " << parser.value("bench-warmup") << parser.value("bench-iterations");
+			return -1;
+		}
+		TestExecutor::maxParallelTools() = parser.value("async-tools").toInt();
+		if (TestExecutor::maxParallelTools()<1)
+		{
+			qDebug() << "Invalid number of asynchronous tools " << parser.value("async-tools");
+			return -1;
+		}
+
+		//check that performance counters are available
+		if (parser.isSet("counters"))
+		{
+			QByteArray error = PerfCounters().open();
+			if (error.isEmpty())
+			{
+				PerfCounters::enabled() = true;
+			}
+			else
+			{
+				qDebug() << "Performance counters are not available:" << error;
+			}
+		}
+
+		//enable profiler
+		if (parser.isSet("profile"))
+		{
+#ifdef Q_OS_LINUX
+			if (threads>1)
+			{
+				qDebug() << "Profiling cannot be combined with threads!";
+				return -1;
+			}
+			SamplingProfiler::enabled() = true;
+#else
+			qDebug() << "Profiling is not available on this platform!";
+#endif
+		}
+
+		//worker process of parallel test run
+		if (parser.isSet("worker-pipe"))
+		{
+			QFile instream;
+			instream.open(stdin, QFile::ReadOnly);
+			QFile outstream;
+			outstream.open(stdout, QFile::WriteOnly);
+#ifdef Q_OS_LINUX
+			installBacktraceHandler(STDOUT_FILENO);
+#endif
+			if (global_init) global_init();
+			return runWorker(instream, outstream, outstream, debug_output);
+		}
+
+		//worker of distributed test run
+#ifdef QT_NETWORK_LIB
+		if (parser.isSet("worker"))
+		{
+			QDir(".").mkdir("out");
+			if (global_init) global_init();
+			return runNetworkWorker(worker_host, worker_port, debug_output) ? 0 : -1;
+		}
+#endif
+
+		//select tests (and list them only)
+		QList<TestCase> test_cases = selectTests(s_filter, l_filter);
+		if (shard_count>1) test_cases = selectShard(test_cases, shard_index, shard_count, parser.value("shard-timings"));
+		if (parser.isSet("list"))
+		{
+			QTextStream out(stdout);
+			foreach(const TestCase& test_case, test_cases)
+			{
+				out << test_case.name << "()\n";
+			}
+			return 0;
+		}
+
+		//create folder for test output data and delete output files of previous test runs (before starting tests - they might run in parallel)
+		QString ram_out;
+		if (parser.isSet("ram-out"))
+		{
+			ram_out = createRamOutputFolder();
+			if (ram_out.isEmpty()) return -1;
+		}
+		else
+		{
+			restoreDiskOutputFolder(); //link to the RAM output folder of a failed run with --ram-out
+			QDir(".").mkdir("out");
+			removeOldOutputFiles();
+		}
 
 		//open output stream
 		QFile outstream;
 		outstream.open(stdout, QFile::WriteOnly);
 
+		//global initialization
+		if (global_init) global_init();
+
+		if (debug_output)
+		{
+			outstream.write("Startup time: " + QByteArray::number(timer_startup.nsecsElapsed()/1e6, 'f', 2) + " ms (application, command line, test selection, global initialization)\n");
+			outstream.flush();
+		}
+
 		//run tests
 		QElapsedTimer timer_all;
 		timer_all.start();
-		QElapsedTimer timer;
-		int c_failed = 0;
-		int c_skipped = 0;
-        int c_passed = 0;
-        foreach (TestExecutor* test, testList())
+		TestSummary summary;
+		ResultCache cache("out/tfw_incremental.tsv");
+		TimingDatabase timings("out/tfw_timings.tsv");
+		QList<TestResult> results;
+		ResultHandler handle_result = [&](const TestResult& result)
 		{
-            QByteArray test_name = test->name();
+			QMutexLocker locker(&outputMutex());
+			writeResult(outstream, result, summary);
+			if (incremental) cache.update(result);
+			timings.add(result);
+			results << result;
+		};
 
-			//delete output files of previous test runs
-			QStringList old_files = Helper::findFiles("out/", test_name.left(test_name.length()-5)+"*.*", false);
-			foreach(QString old_file, old_files)
+		//replay cached results
+		if (incremental)
+		{
+			QList<TestCase> outdated;
+			foreach(const TestCase& test_case, test_cases)
 			{
-				QFileInfo file_info(old_file);
-				if(file_info.isFile() && file_info.exists())
+				if (cache.isUpToDate(test_case.name))
+				{
+					TestResult result;
+					result.name = test_case.name;
+					result.result = "PASS";
+					result.message = "cached result (test executable, tools and test data unchanged)";
+					writeResult(outstream, result, summary);
+				}
+				else
 				{
-					QFile::remove(old_file);
+					outdated << test_case;
 				}
 			}
+			test_cases = outdated;
+		}
 
-            for (int i=0; i<test->testCount(); ++i)
+		QElapsedTimer timer_parallel;
+		timer_parallel.start();
+		int makespan_predicted = -1;
+		if (jobs>1 || threads>1)
+		{
+			makespan_predicted = scheduleLongestFirst(test_cases, timings, std::max(jobs, threads));
+		}
+		else if (parser.isSet("coordinator")) //number of workers is unknown: order only
+		{
+			scheduleLongestFirst(test_cases, timings, 1);
+		}
+		if (parser.isSet("coordinator"))
+		{
+#ifdef QT_NETWORK_LIB
+			if (!runCoordinator(test_cases, parser.value("coordinator-bind"), coordinator_port, outstream, handle_result)) return -1;
+#endif
+		}
+		else if (fork_mode)
+		{
+			runInForkedProcesses(test_cases, jobs, debug_output, outstream, handle_result);
+		}
+		else if (jobs>1)
+		{
+			QStringList worker_args;
+			if (debug_output) worker_args << "-d";
+			worker_args << "--async-tools" << QString::number(TestExecutor::maxParallelTools());
+			worker_args << "--timeout" << QString::number(defaultTimeout());
+			if (PerfCounters::enabled()) worker_args << "--counters";
+			if (SamplingProfiler::enabled()) worker_args << "--profile";
+			worker_args << "--bench-warmup" << QString::number(TestExecutor::benchmarkWarmup()) << "--bench-iterations" << QString::number(TestExecutor::benchmarkIterations());
+			runInWorkers(test_cases, jobs, worker_args, outstream, handle_result);
+		}
+		else if (threads>1)
+		{
+			runInThreads(test_cases, threads, debug_output, outstream, handle_result);
+		}
+		else
+		{
+			foreach(const TestCase& test_case, test_cases)
 			{
-                std::function<void()> method = test->method(i);
-				QByteArray method_name = test->methodName(i);
-                QByteArray test_and_method = test_name + "::" + method_name;
+				handle_result(runTest(test_case, debug_output, outstream));
+			}
+		}
+		teardownClasses(outstream);
+		if (incremental) cache.store();
+		int makespan_actual = timer_parallel.elapsed();
 
-                //string filter
-				if (!test_and_method.contains(s_filter))
+		outstream.write("\n");
+		outstream.write("PASSED : " + QByteArray::number(summary.passed).rightJustified(3, ' ') + "\n");
+		outstream.write("SKIPPED: " + QByteArray::number(summary.skipped).rightJustified(3, ' ') + "\n");
+		outstream.write("FAILED : " + QByteArray::number(summary.failed).rightJustified(3, ' ') + "\n");
+		outstream.write("TIME   : " + Helper::elapsedTime(timer_all, true) + "\n");
+		if (makespan_predicted!=-1)
+		{
+			outstream.write("MAKESPAN: predicted " + Helper::elapsedTime(makespan_predicted, true) + ", actual " + Helper::elapsedTime(makespan_actual, true) + "\n");
+		}
+
+		//report performance regressions (compared to the durations of previous runs)
+		if (perf_factor>0.0)
+		{
+			const int min_history = 3;
+			const int min_difference_ms = 100; //ignore noise of very short test methods
+			QByteArrayList regressions;
+			foreach(const TestResult& result, results)
+			{
+				if (result.result!="PASS" || timings.count(result.name)<min_history) continue;
+				int median = timings.median(result.name);
+				if (result.elapsed_ms > perf_factor * median && result.elapsed_ms - median > min_difference_ms)
 				{
-					continue;
+					regressions << "  " + result.name + "()\t" + Helper::elapsedTime(result.elapsed_ms, true) + " (median " + Helper::elapsedTime(median, true) + ")\n";
 				}
+			}
+			outstream.write("\n");
+			outstream.write("PERFORMANCE REGRESSIONS (factor " + QByteArray::number(perf_factor) + "): " + QByteArray::number(regressions.count()) + "\n");
+			foreach(const QByteArray& line, regressions)
+			{
+				outstream.write(line);
+			}
+		}
+		timings.store();
 
-				//test list filter
-				if (!l_filter.isEmpty())
+		//tear down RAM output folder (kept for debugging if tests failed)
+		if (!ram_out.isEmpty())
+		{
+			if (summary.failed==0)
+			{
+				restoreDiskOutputFolder();
+			}
+			else
+			{
+				outstream.write("\nTest output kept in RAM folder: " + ram_out.toUtf8() + " (other output is in '" + diskOutputFolder().toUtf8() + "' until the next test run)\n");
+			}
+		}
+		outstream.close();
+
+		return summary.failed;
+	}
+
+	//Parses a numeric field of a line (leading/trailing whitespaces and a leading '+' are allowed). Returns 'false' if the field is not numeric.
+	inline bool parseNumber(const char* begin, const char* end, double& value)
+	{
+		while (begin<end && isspace(static_cast<unsigned char>(*begin))) ++begin;
+		while (end>begin && isspace(static_cast<unsigned char>(end[-1]))) --end;
+		if (begin<end && *begin=='+') ++begin;
+		if (begin==end) return false;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars>=201611L
+		std::from_chars_result result = std::from_chars(begin, end, value);
+		return result.ec==std::errc() && result.ptr==end;
+#else
+		//floating-point std::from_chars is not available (e.g. libstdc++ before GCC 11, Apple libc++): parse without copying, independent of the locale
+		bool ok = false;
+		value = QByteArray::fromRawData(begin, (int)(end-begin)).toDouble(&ok);
+		return ok;
+#endif
+	}
+
+	//Compares two differing lines of comareFiles using the numeric delta. Returns an empty string if the lines are equal within the delta.
+	inline QString compareLines(const QByteArray& aline, const QByteArray& eline, int line_nr, double delta, bool delta_is_percentage, char separator)
+	{
+		//not delta allowed > no numeric comparison
+		if (delta == 0.0)
+		{
+			return "Differing line "  + QByteArray::number(line_nr) + "\nactual   : " + aline + "\nexpected : " + eline;
+		}
+
+		//numeric comparison (fields are compared in place, without splitting the lines)
+		if (aline.count(separator) != eline.count(separator))
+		{
+			return "Differing line "  + QByteArray::number(line_nr) + " (different token count)\nactual   : " + aline + "\nexpected : " + eline;
+		}
+
+		const char* a_pos = aline.constData();
+		const char* a_end = a_pos + aline.size();
+		const char* e_pos = eline.constData();
+		const char* e_end = e_pos + eline.size();
+		while (true)
+		{
+			const char* a_item_end = static_cast<const char*>(memchr(a_pos, separator, a_end-a_pos));
+			if (a_item_end==nullptr) a_item_end = a_end;
+			const char* e_item_end = static_cast<const char*>(memchr(e_pos, separator, e_end-e_pos));
+			if (e_item_end==nullptr) e_item_end = e_end;
+
+			if (a_item_end-a_pos!=e_item_end-e_pos || memcmp(a_pos, e_pos, a_item_end-a_pos)!=0)
+			{
+				double a_line_value;
+				bool a_item_is_numeric = parseNumber(a_pos, a_item_end, a_line_value);
+
+				double e_line_value;
+				bool e_item_is_numeric = parseNumber(e_pos, e_item_end, e_line_value);
+
+				if (!a_item_is_numeric || !e_item_is_numeric)
 				{
-					bool found = false;
-					foreach(QString filter, l_filter)
-					{
-						if (test_and_method+"()"==filter || test_and_method==filter)
-						{
-							found = true;
-						}
-					}
-					if (!found) continue;
+					return "Differing line "  + QByteArray::number(line_nr) + " (non-numeric difference)\nactual   : " + aline + "\nexpected : " + eline;
 				}
 
-				//execute test
-				skipped() = false;
-				failed() = false;
-                message() = "";
-				timer.restart();
-				try
+				double abs_diff = fabs(a_line_value-e_line_value);
+				if (delta_is_percentage)
 				{
-					if (debug_output)
+					double rel_diff = fabs(a_line_value-e_line_value)/e_line_value;
+					if (rel_diff > delta/100.0)
 					{
-                        outstream.write("Performing " + test_name + ":" + method_name + "\n");
-						outstream.flush();
+						return "Differing numeric value in line "  + QByteArray::number(line_nr) + " (relative difference too big)\nactual   : " + QString::number(a_line_value) + "\nexpected : " + QString::number(e_line_value) + "\ndelta rel: " + QString::number(rel_diff, 'g', 4);
 					}
-					method();
-				}
-				catch (Exception& e)
-				{
-					QByteArray msg;
-					msg += "exception: Exception (cppCORE)\n";
-					msg += "location : " + name(e.file()) + ":" + QByteArray::number(e.line()) + "\n";
-					msg += "message  : " + e.message().toUtf8() + "\n";
-					message() = msg;
-					failed() = true;
-				}
-				catch (std::exception& e)
-				{
-					QByteArray msg;
-					msg += "exception: std::exception\n";
-					msg += "message  : " + QByteArray(e.what()) + "\n";
-					message() = msg;
-					failed() = true;
-				}
-				catch (...)
-				{
-					message() = "unknown exception";
-					failed() = true;
-                }
-
-				//evaluate what happened
-				QByteArray result;
-				if (failed())
-				{
-					result = "FAIL!";
-					++c_failed;
-				}
-				else if(skipped())
-				{
-					result = "SKIP";
-					++c_skipped;
 				}
 				else
 				{
-					result = "PASS";
-					++c_passed;
-				}
-
-				//output
-				outstream.write(result + "\t" + test_and_method + "()\t" + Helper::elapsedTime(timer, true) + "\n");
-				if (!message().isEmpty())
-				{
-					QList<QByteArray> parts = message().trimmed().split('\n');
-					foreach(QByteArray part, parts)
+					if (abs_diff > delta)
 					{
-						outstream.write("  " + part.trimmed() + "\n");
+						return "Differing numeric value in line "  + QByteArray::number(line_nr) + " (absolute difference too big)\nactual   : " + QString::number(a_line_value) + "\nexpected : " + QString::number(e_line_value)+ "\ndelta abs: " + QString::number(abs_diff, 'g', 4);
 					}
 				}
-				outstream.flush();
 			}
+
+			if (a_item_end==a_end) break;
+			a_pos = a_item_end + 1;
+			e_pos = e_item_end + 1;
 		}
 
-		outstream.write("\n");
-		outstream.write("PASSED : " + QByteArray::number(c_passed).rightJustified(3, ' ') + "\n");
-		outstream.write("SKIPPED: " + QByteArray::number(c_skipped).rightJustified(3, ' ') + "\n");
-		outstream.write("FAILED : " + QByteArray::number(c_failed).rightJustified(3, ' ') + "\n");
-		outstream.write("TIME   : " + Helper::elapsedTime(timer_all, true) + "\n");
-		outstream.close();
+		return "";
+	}
+
+	//Returns the next line of a memory-mapped file (without line ending and without copying the data) and moves 'pos' to the start of the following line
+	inline QByteArray nextMappedLine(const char*& pos, const char* end)
+	{
+		const char* line_end = static_cast<const char*>(memchr(pos, '\n', end-pos));
+		if (line_end==nullptr) line_end = end;
+		const char* content_end = line_end;
+		while (content_end>pos && (content_end[-1]=='\n' || content_end[-1]=='\r')) --content_end;
+
+		QByteArray line = QByteArray::fromRawData(pos, content_end-pos);
+		pos = line_end<end ? line_end+1 : end;
+		return line;
+	}
+
+	/**
+	 * @brief compareMappedFiles
+	 * Fast path of comareFiles for uncompressed files: the files are memory-mapped and compared block-wise.
+	 * Only the part starting with the line that contains the first difference is compared line by line.
+	 * @return 'false' if the files cannot be handled (e.g. gzipped or empty files), 'true' otherwise. The comparison result is stored in 'result'.
+	 */
+	inline bool compareMappedFiles(QString actual, QString expected, double delta, bool delta_is_percentage, char separator, QString& result)
+	{
+		QFile afile(actual);
+		QFile efile(expected);
+		if (!afile.open(QFile::ReadOnly) || !efile.open(QFile::ReadOnly)) return false;
+		if (afile.peek(2)=="\x1f\x8b" || efile.peek(2)=="\x1f\x8b") return false;
+
+		qint64 asize = afile.size();
+		qint64 esize = efile.size();
+		if (asize==0 || esize==0) return false;
+		const char* adata = reinterpret_cast<const char*>(afile.map(0, asize));
+		const char* edata = reinterpret_cast<const char*>(efile.map(0, esize));
+		if (adata==nullptr || edata==nullptr) return false;
+
+		//bulk comparison
+		const qint64 block_size = 1 << 20;
+		qint64 min_size = std::min(asize, esize);
+		qint64 pos = 0;
+		while (pos<min_size)
+		{
+			qint64 length = std::min(block_size, min_size-pos);
+			if (memcmp(adata+pos, edata+pos, length)!=0) break;
+			pos += length;
+		}
+		if (pos==min_size && asize==esize)
+		{
+			result = "";
+			return true;
+		}
+
+		//line-by-line comparison starting with the line that contains the first differing block (the data before is identical in both files)
+		while (pos>0 && adata[pos-1]!='\n') --pos;
+		int line_nr = 1 + std::count(adata, adata+pos, '\n');
+		const char* apos = adata + pos;
+		const char* aend = adata + asize;
+		const char* epos = edata + pos;
+		const char* eend = edata + esize;
+		while (apos<aend && epos<eend)
+		{
+			QByteArray aline = nextMappedLine(apos, aend);
+			QByteArray eline = nextMappedLine(epos, eend);
+			if(aline!=eline)
+			{
+				result = compareLines(aline, eline, line_nr, delta, delta_is_percentage, separator);
+				if (!result.isEmpty()) return true;
+			}
+			++line_nr;
+		}
 
-		return c_failed;
+		//compare rest (ignore lines containing only whitespaces)
+		QString arest = QString::fromUtf8(apos, aend-apos).trimmed();
+		if (!arest.isEmpty())
+		{
+			result = "Actual file '" + actual + "' contains more data than expected file '" + expected + "': " + arest;
+			return true;
+		}
+		QString erest = QString::fromUtf8(epos, eend-epos).trimmed();
+		if (!erest.isEmpty())
+		{
+			result = "Expected file '" + expected + "' contains more data than actual file '" + actual + "': " + erest;
+			return true;
+		}
+
+		result = "";
+		return true;
 	}
 
 	/**
@@ -373,6 +3299,10 @@ namespace TFW
 	   actual = QFileInfo(actual).absoluteFilePath();
 	   expected = QFileInfo(expected).absoluteFilePath();
 
+		//fast path for uncompressed files
+		QString result;
+		if (compareMappedFiles(actual, expected, delta, delta_is_percentage, separator, result)) return result;
+
 		//open files
 		VersatileFile astream(actual);
 		astream.open();
@@ -383,57 +3313,12 @@ namespace TFW
 		int line_nr = 1;
 		while (!astream.atEnd() && !estream.atEnd())
 		{
-			QString aline = astream.readLine(true);
-			QString eline = estream.readLine(true);
+			QByteArray aline = astream.readLine(true);
+			QByteArray eline = estream.readLine(true);
 			if(aline!=eline)
 			{
-				//not delta allowed > no numeric comparison
-				if (delta == 0.0)
-				{
-					return "Differing line "  + QByteArray::number(line_nr) + "\nactual   : " + aline + "\nexpected : " + eline;
-				}
-
-				//numeric comparison
-				QStringList a_line_items = aline.split(separator);
-				QStringList e_line_items = eline.split(separator);
-				if (a_line_items.size() != e_line_items.size())
-				{
-					return "Differing line "  + QByteArray::number(line_nr) + " (different token count)\nactual   : " + aline + "\nexpected : " + eline;
-				}
-
-				for (int i=0; i<a_line_items.size(); ++i)
-				{
-					if (a_line_items[i]!=e_line_items[i])
-					{
-						bool a_item_is_numeric;
-						float a_line_value = a_line_items[i].toFloat(&a_item_is_numeric);
-
-						bool e_item_is_numeric;
-						float e_line_value = e_line_items[i].toFloat(&e_item_is_numeric);
-
-						if (!a_item_is_numeric || !e_item_is_numeric)
-						{
-							return "Differing line "  + QByteArray::number(line_nr) + " (non-numeric difference)\nactual   : " + aline + "\nexpected : " + eline;
-						}
-
-						double abs_diff = fabs(a_line_value-e_line_value);
-						if (delta_is_percentage)
-						{
-							double rel_diff = fabs(a_line_value-e_line_value)/e_line_value;
-							if (rel_diff > delta/100.0)
-							{
-								return "Differing numeric value in line "  + QByteArray::number(line_nr) + " (relative difference too big)\nactual   : " + QString::number(a_line_value) + "\nexpected : " + QString::number(e_line_value) + "\ndelta rel: " + QString::number(rel_diff, 'g', 4);
-							}
-						}
-						else
-						{
-							if (abs_diff > delta)
-							{
-								return "Differing numeric value in line "  + QByteArray::number(line_nr) + " (absolute difference too big)\nactual   : " + QString::number(a_line_value) + "\nexpected : " + QString::number(e_line_value)+ "\ndelta abs: " + QString::number(abs_diff, 'g', 4);
-							}
-						}
-					}
-				}
+				result = compareLines(aline, eline, line_nr, delta, delta_is_percentage, separator);
+				if (!result.isEmpty()) return result;
 			}
 			++line_nr;
 		}
@@ -447,12 +3332,93 @@ namespace TFW
 		return "";
 	}
 
+	//Adds the squared RGB distance and the number of compared pixels of a scanline. Pixels that have the color 'ignored_rgb' in both images are skipped (if 'use_ignored' is set).
+	inline void comparePngScanline(const QRgb* actual, const QRgb* expected, int width, bool use_ignored, QRgb ignored_rgb, quint64& squared_distance, qint64& compared_pixels)
+	{
+		int x = 0;
+
+#if defined(TFW_SIMD_AVX2) || defined(TFW_SIMD_SSE2)
+		//alpha is masked out, so it does not contribute to the distance. The ignored value cannot match a masked pixel if no color is ignored.
+		const quint32 ignored_value = use_ignored ? (ignored_rgb & 0x00FFFFFF) : 0xFFFFFFFF;
+		const int max_block_iterations = 4096; //each 32-bit lane grows by at most 4*255^2 per iteration
+#endif
+
+#if defined(TFW_SIMD_AVX2)
+		const __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i ignored = _mm256_set1_epi32(ignored_value);
+		const __m256i zero = _mm256_setzero_si256();
+		while (x+8<=width)
+		{
+			__m256i sum = _mm256_setzero_si256();
+			for (int i=0; i<max_block_iterations && x+8<=width; ++i, x+=8)
+			{
+				__m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(actual+x)), rgb_mask);
+				__m256i e = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(expected+x)), rgb_mask);
+				__m256i skip = _mm256_and_si256(_mm256_cmpeq_epi32(a, ignored), _mm256_cmpeq_epi32(e, ignored));
+				a = _mm256_andnot_si256(skip, a);
+				e = _mm256_andnot_si256(skip, e);
+				compared_pixels += 8 - qPopulationCount(static_cast<quint32>(_mm256_movemask_ps(_mm256_castsi256_ps(skip))));
+
+				__m256i diff_lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(e, zero));
+				__m256i diff_hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(e, zero));
+				sum = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_madd_epi16(diff_lo, diff_lo), _mm256_madd_epi16(diff_hi, diff_hi)));
+			}
+
+			quint32 lanes[8];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sum);
+			for (int i=0; i<8; ++i) squared_distance += lanes[i];
+		}
+#elif defined(TFW_SIMD_SSE2)
+		const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i ignored = _mm_set1_epi32(ignored_value);
+		const __m128i zero = _mm_setzero_si128();
+		while (x+4<=width)
+		{
+			__m128i sum = _mm_setzero_si128();
+			for (int i=0; i<max_block_iterations && x+4<=width; ++i, x+=4)
+			{
+				__m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(actual+x)), rgb_mask);
+				__m128i e = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(expected+x)), rgb_mask);
+				__m128i skip = _mm_and_si128(_mm_cmpeq_epi32(a, ignored), _mm_cmpeq_epi32(e, ignored));
+				a = _mm_andnot_si128(skip, a);
+				e = _mm_andnot_si128(skip, e);
+				compared_pixels += 4 - qPopulationCount(static_cast<quint32>(_mm_movemask_ps(_mm_castsi128_ps(skip))));
+
+				__m128i diff_lo = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(e, zero));
+				__m128i diff_hi = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(e, zero));
+				sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(diff_lo, diff_lo), _mm_madd_epi16(diff_hi, diff_hi)));
+			}
+
+			quint32 lanes[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+			for (int i=0; i<4; ++i) squared_distance += lanes[i];
+		}
+#endif
+
+		//scalar fallback and remaining pixels
+		for (; x<width; ++x)
+		{
+			// Ignore pixels, if both are ignored_color
+			if (use_ignored && (actual[x] & 0x00FFFFFF)==(ignored_rgb & 0x00FFFFFF) && (expected[x] & 0x00FFFFFF)==(ignored_rgb & 0x00FFFFFF)) continue;
+
+			//calculate squared distance
+			int dr = qRed(actual[x]) - qRed(expected[x]);
+			int dg = qGreen(actual[x]) - qGreen(expected[x]);
+			int db = qBlue(actual[x]) - qBlue(expected[x]);
+			squared_distance += dr * dr + dg * dg + db * db;
+
+			//count used pixels
+			compared_pixels++;
+		}
+	}
+
 	/**
 	 * @brief comparePngFiles
 	 * Compares two PNG images pixel by pixel using normalized RGB distance,
 	 * optionally ignoring pixels where both images match the specified ignored_color.
 	 * Returns an empty string if the similarity score meets the cutoff threshold;
 	 * otherwise returns an error message with the calculated similarity.
+	 * Scanlines of large images are compared in several threads. The distance is summed up as integer, so the score does not depend on the number of threads.
 	 * @param actual
 	 * @param expected
 	 * @param cutoff
@@ -473,67 +3439,311 @@ namespace TFW
 		const int width = actual_image.width();
 		const int height = actual_image.height();
 
-		double squared_distance = 0.0;
-		int compared_pixels = 0;
+		//pixels are opaque, so they are equal to 'ignored_color' only if it is an opaque RGB color (that is what QColor comparison of the pixels did)
+		const bool use_ignored = QColor(ignored_color.rgb())==ignored_color;
+		const QRgb ignored_rgb = ignored_color.rgb();
+
+		//split scanlines into chunks
+		const qint64 min_pixels_per_thread = 1 << 18;
+		int thread_count = std::max(1, std::min(QThread::idealThreadCount(), (int)((qint64)width * height / min_pixels_per_thread)));
+		thread_count = std::min(thread_count, std::max(1, height));
+		std::vector<quint64> chunk_distance(thread_count, 0);
+		std::vector<qint64> chunk_pixels(thread_count, 0);
+		auto compareChunk = [&](int chunk)
+		{
+			int start = (qint64)height * chunk / thread_count;
+			int end = (qint64)height * (chunk+1) / thread_count;
+			for (int y=start; y<end; y++)
+			{
+				const QRgb* line_actual = reinterpret_cast<const QRgb*>(actual_image.constScanLine(y));
+				const QRgb* line_expected = reinterpret_cast<const QRgb*>(expected_image.constScanLine(y));
+				comparePngScanline(line_actual, line_expected, width, use_ignored, ignored_rgb, chunk_distance[chunk], chunk_pixels[chunk]);
+			}
+		};
+
+		if (thread_count==1)
+		{
+			compareChunk(0);
+		}
+		else
+		{
+			std::vector<std::thread> threads;
+			for (int chunk=0; chunk<thread_count; ++chunk)
+			{
+				threads.emplace_back(compareChunk, chunk);
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		quint64 squared_distance = 0;
+		qint64 compared_pixels = 0;
+		for (int chunk=0; chunk<thread_count; ++chunk)
+		{
+			squared_distance += chunk_distance[chunk];
+			compared_pixels += chunk_pixels[chunk];
+		}
+
+		if (compared_pixels == 0) return ""; // ignored all pixels => identical images
+		double similarity = 1.0 - ((double)squared_distance / ((double)compared_pixels*3.0 * 255.0 * 255.0));
+		if (similarity < cutoff)
+			return "The similarity score for the images is insufficient: got "
+				   + QString::number(similarity)
+				   + ", but expected at least "
+				   + QString::number(cutoff);
+		return "";
+	}
+
+	//Returns a literal that is contained in every match of the regular expression, or an empty string if no such literal is found.
+	//It is used to skip lines that cannot match without running the regular expression. Patterns with alternatives, inline options or case-insensitive matching are not analyzed.
+	inline QByteArray requiredLiteral(const QRegularExpression& regexp)
+	{
+		if (regexp.patternOptions() & (QRegularExpression::CaseInsensitiveOption | QRegularExpression::ExtendedPatternSyntaxOption)) return "";
+		QString pattern = regexp.pattern();
+		if (pattern.contains('|') || pattern.contains("(?")) return "";
+
+		QString best;
+		QString current;
+		auto finalize = [&]()
+		{
+			if (current.length()>best.length()) best = current;
+			current.clear();
+		};
+
+		int depth = 0;
+		for (int i=0; i<pattern.length(); ++i)
+		{
+			QChar c = pattern[i];
+			if (c=='\\')
+			{
+				if (i+1<pattern.length() && !pattern[i+1].isLetterOrNumber()) //escaped literal
+				{
+					++i;
+					if (depth==0) current += pattern[i];
+				}
+				else if (i+1<pattern.length() && QString("dDwWsSbBAzZGhHvVRNKntrfea").contains(pattern[i+1])) //single-character class, anchor or control character
+				{
+					++i;
+					finalize();
+				}
+				else //escape of unknown length, e.g. \x41, \101, \cA, \k<name>, \p{L} or \Q...\E
+				{
+					return "";
+				}
+			}
+			else if (c=='[') //skip character class
+			{
+				finalize();
+				++i;
+				if (i<pattern.length() && pattern[i]=='^') ++i;
+				if (i<pattern.length() && pattern[i]==']') ++i;
+				while (i<pattern.length() && pattern[i]!=']')
+				{
+					if (pattern[i]=='\\')
+					{
+						++i;
+					}
+					else if (pattern[i]=='[' && i+1<pattern.length() && QString(":.=").contains(pattern[i+1])) //POSIX class, e.g. [:digit:]
+					{
+						int end = pattern.indexOf(QString(pattern[i+1]) + "]", i+2);
+						if (end==-1) return "";
+						i = end + 1;
+						continue;
+					}
+					++i;
+				}
+				if (i>=pattern.length()) return ""; //unterminated character class
+			}
+			else if (c=='(')
+			{
+				finalize();
+				++depth;
+			}
+			else if (c==')')
+			{
+				finalize();
+				--depth;
+			}
+			else if (c=='?' || c=='*') //previous character is optional
+			{
+				current.chop(1);
+				finalize();
+			}
+			else if (c=='{') //previous character can be optional - skip quantifier
+			{
+				current.chop(1);
+				finalize();
+				while (i<pattern.length() && pattern[i]!='}') ++i;
+			}
+			else if (c=='+') //previous character is required, but can be repeated
+			{
+				finalize();
+			}
+			else if (c=='.' || c=='^' || c=='$')
+			{
+				finalize();
+			}
+			else if (depth==0)
+			{
+				current += c;
+			}
+		}
+		finalize();
+
+		if (best.length()<2) return "";
+		return best.toUtf8();
+	}
 
-		for (int y=0; y<height; y++)
+	//Removes all lines that match at least one of the regular expressions. The file is filtered in one pass into a temporary file, which then replaces the original file.
+	inline QString removeLinesMatching(QString filename, QList<QRegularExpression> regexps)
+	{
+		//prepare regular expressions
+		QList<QByteArray> literals;
+		for (int i=0; i<regexps.count(); ++i)
 		{
-			QRgb* line_actual = reinterpret_cast<QRgb*>(actual_image.scanLine(y));
-			QRgb* line_expected = reinterpret_cast<QRgb*>(expected_image.scanLine(y));
+			if (!regexps[i].isValid()) return "Invalid regular expression '" + regexps[i].pattern() + "': " + regexps[i].errorString();
+			regexps[i].optimize();
+			literals << requiredLiteral(regexps[i]);
+		}
 
-			for (int x=0; x<width; x++)
-			{
-				QColor color_actual(line_actual[x]);
-				QColor color_expected(line_expected[x]);
+		//open files
+		QFile file(filename);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return "Could not open file '" + filename + " for reading!";
+		QSaveFile output(filename);
+		if (!output.open(QIODevice::WriteOnly)) return "Could not open file '" + filename + " for writing!";
 
-				// Ignore pixels, if both are ignored_color
-				if (color_actual == ignored_color && color_expected == ignored_color) continue;
+		//filter lines
+		while(!file.atEnd())
+		{
+			QByteArray line = file.readLine();
 
-				//calculate squared distance
-				int dr = qRed(line_actual[x]) - qRed(line_expected[x]);
-				int dg = qGreen(line_actual[x]) - qGreen(line_expected[x]);
-				int db = qBlue(line_actual[x]) - qBlue(line_expected[x]);
-				squared_distance += dr * dr + dg * dg + db * db;
+			bool matched = false;
+			QString line_str;
+			for (int i=0; i<regexps.count() && !matched; ++i)
+			{
+				if (!literals[i].isEmpty() && !line.contains(literals[i])) continue;
 
-				//count used pixels
-				compared_pixels++;
+				if (line_str.isNull()) line_str = QString::fromUtf8(line);
+				matched = regexps[i].match(line_str).hasMatch();
 			}
+			if (matched) continue;
+
+			output.write(line);
 		}
+		file.close();
+
+		//replace input file
+		if (!output.commit()) return "Could not write file '" + filename + "': " + output.errorString();
 
-		if (compared_pixels == 0) return ""; // ignored all pixels => identical images
-		double similarity = 1.0 - (squared_distance / (compared_pixels*3.0 * 255.0 * 255.0));
-		if (similarity < cutoff)
-			return "The similarity score for the images is insufficient: got "
-				   + QString::number(similarity)
-				   + ", but expected at least "
-				   + QString::number(cutoff);
 		return "";
 	}
 
 	inline QString removeLinesMatching(QString filename, QRegularExpression regexp)
 	{
-		QFile file(filename);
-		QList<QByteArray> output;
+		return removeLinesMatching(filename, QList<QRegularExpression>() << regexp);
+	}
 
-		//read input
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return "Could not open file '" + filename + " for reading!";
-		while(!file.atEnd())
+	///Complexity classes for EXPECT_COMPLEXITY (ordered from best to worst)
+	enum Complexity
+	{
+		O_1,
+		O_LOG_N,
+		O_N,
+		O_N_LOG_N,
+		O_N2
+	};
+
+	inline QByteArray complexityName(Complexity complexity)
+	{
+		switch(complexity)
 		{
-			QByteArray line = file.readLine();
-			if (regexp.match(line).hasMatch()) continue;
-			output.append(line);
+			case O_1: return "O(1)";
+			case O_LOG_N: return "O(log n)";
+			case O_N: return "O(n)";
+			case O_N_LOG_N: return "O(n log n)";
+			case O_N2: return "O(n^2)";
 		}
-		file.close();
+		return "";
+	}
 
-		//store output
-		if (!file.open(QIODevice::WriteOnly)) return "Could not open file '" + filename + " for writing!";
-		foreach(const QByteArray& line, output)
+	/**
+	 * @brief checkComplexity
+	 * Measures the run time of 'function' for each input size (minimum of several repetitions) and fits the timings against O(1), O(log n), O(n), O(n log n) and O(n^2).
+	 * For each complexity class, the factor c of 't = c * f(n)' is determined by least squares. The class with the smallest normalized RMS error is the best fit.
+	 * @return empty string if the best fit is not worse than 'expected', otherwise a message with the fits and timings.
+	 */
+	inline QString checkComplexity(Complexity expected, QList<int> sizes, std::function<void(int)> function, int repetitions = 5)
+	{
+		if (sizes.count()<3) return "At least three input sizes are required!";
+
+		//measure
+		std::vector<double> times;
+		foreach(int n, sizes)
 		{
-			file.write(line);
+			qint64 min_ns = std::numeric_limits<qint64>::max();
+			for (int r=0; r<repetitions; ++r)
+			{
+				QElapsedTimer timer;
+				timer.start();
+				function(n);
+				min_ns = std::min(min_ns, timer.nsecsElapsed());
+			}
+			times.push_back(min_ns);
 		}
-		file.close();
 
-		return "";
+		//fit
+		double mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+		auto model = [](Complexity complexity, double n)
+		{
+			switch(complexity)
+			{
+				case O_1: return 1.0;
+				case O_LOG_N: return std::log2(std::max(n, 2.0));
+				case O_N: return n;
+				case O_N_LOG_N: return n * std::log2(std::max(n, 2.0));
+				case O_N2: return n * n;
+			}
+			return 1.0;
+		};
+		Complexity best = O_1;
+		double best_rms = std::numeric_limits<double>::max();
+		QByteArray fits;
+		for (int c=O_1; c<=O_N2; ++c)
+		{
+			Complexity complexity = static_cast<Complexity>(c);
+			double sum_tf = 0.0;
+			double sum_ff = 0.0;
+			for (int i=0; i<sizes.count(); ++i)
+			{
+				double f = model(complexity, sizes[i]);
+				sum_tf += times[i] * f;
+				sum_ff += f * f;
+			}
+			double factor = sum_tf / sum_ff;
+			double sum_squares = 0.0;
+			for (int i=0; i<sizes.count(); ++i)
+			{
+				double residual = times[i] - factor * model(complexity, sizes[i]);
+				sum_squares += residual * residual;
+			}
+			double rms = std::sqrt(sum_squares / sizes.count()) / mean;
+			fits += (fits.isEmpty() ? "" : ", ") + complexityName(complexity) + " " + QByteArray::number(100.0*rms, 'f', 1) + "%";
+			if (rms<best_rms)
+			{
+				best_rms = rms;
+				best = complexity;
+			}
+		}
+		if (best<=expected) return "";
+
+		QByteArray timings;
+		for (int i=0; i<sizes.count(); ++i)
+		{
+			timings += (timings.isEmpty() ? "" : ", ") + QByteArray::number(sizes[i]) + ": " + QByteArray::number(times[i]/1e6, 'f', 3) + " ms";
+		}
+		return "best fit : " + complexityName(best) + "\nexpected : " + complexityName(expected) + "\nRMS error: " + fits + "\ntimings  : " + timings;
 	}
 
 	/// Helper class to create a test instance and add it to the test list
@@ -549,10 +3759,83 @@ namespace TFW
 				qDebug() << "Test name must end with '_Test', but does not: " + name;
 			}
 
-			//add tests
-			TestExecutor* inst = new T();
-			inst->setName(name);
-			addTest(inst);
+			//add test class (the instance is created when a test method is executed)
+			addTest(name, &TypeKey<T>::key, []() -> TestExecutor* { return new T(); });
+		}
+	};
+
+	/// Helper class to register a test method name without creating an instance of the test class
+	template <class T>
+	class MethodRegistrar
+	{
+	public:
+		MethodRegistrar(const char* method_name)
+		{
+			testMethods()[&TypeKey<T>::key] << method_name;
+		}
+	};
+
+	/// Helper class to register a tool entry point at static initialization (see REGISTER_TOOL)
+	class ToolRegistrar
+	{
+	public:
+		ToolRegistrar(QString toolname, ToolEntry entry)
+		{
+			registerTool(toolname, entry);
+		}
+	};
+
+	/// Helper class to register that a test class has a setup or teardown (see TEST_CLASS_SETUP)
+	template <class T>
+	class SetupRegistrar
+	{
+	public:
+		SetupRegistrar()
+		{
+			classesWithSetup() << &TypeKey<T>::key;
+		}
+	};
+
+	/// Helper class to register the timeout of a test method (see TEST_TIMEOUT)
+	template <class T>
+	class TimeoutRegistrar
+	{
+	public:
+		TimeoutRegistrar(const char* method_name, int seconds)
+		{
+			testTimeouts()[&TypeKey<T>::key][method_name] = seconds;
+		}
+	};
+
+	/// Helper class to register a resource used by a test class (see USES_RESOURCE)
+	template <class T>
+	class ResourceRegistrar
+	{
+	public:
+		ResourceRegistrar(const char* resource, int units)
+		{
+			testResources()[&TypeKey<T>::key][resource] += units;
+		}
+	};
+
+	/// Helper class to register the memory used by a test class (see MEMORY_MB)
+	template <class T>
+	class MemoryRegistrar
+	{
+	public:
+		MemoryRegistrar(int memory_mb)
+		{
+			testMemory()[&TypeKey<T>::key] = memory_mb;
+		}
+	};
+
+	/// Helper class to declare that a test class needs a QApplication
+	class GuiRegistrar
+	{
+	public:
+		GuiRegistrar()
+		{
+			needsGui() = true;
 		}
 	};
 
@@ -570,8 +3853,51 @@ namespace TFW
 			obj->tests_.push_back({#methodName, [obj]{ obj->methodName(); }}); \
 		} \
 } reg_##methodName{this}; \
+	static inline TFW::MethodRegistrar<TestClassType> static_reg_##methodName{#methodName}; \
 	void methodName()
 
+//Class setup, executed once before the first test method of the class. If it fails, the first test method is reported as failed and the others are skipped.
+//With worker processes (-j, --worker), all test methods of the class are executed in the same worker. The setup has the default timeout (see --timeout).
+#define TEST_CLASS_SETUP \
+	static inline TFW::SetupRegistrar<TestClassType> static_reg_class_setup{}; \
+	void classSetup() override
+
+//Class teardown, executed once after the last test method of the class (only if the setup was successful)
+#define TEST_CLASS_TEARDOWN \
+	static inline TFW::SetupRegistrar<TestClassType> static_reg_class_teardown{}; \
+	void classTeardown() override
+
+//Overrides the default timeout (see --timeout) of a test method of the class, 0 means no timeout
+#define TEST_TIMEOUT(methodName, seconds) \
+	static inline TFW::TimeoutRegistrar<TestClassType> static_timeout_##methodName{#methodName, seconds};
+
+#define TFW_CONCAT_IMPL(a, b) a##b
+#define TFW_CONCAT(a, b) TFW_CONCAT_IMPL(a, b)
+
+//Declares that the test methods of the class use 'units' of a shared resource, e.g. USES_RESOURCE("ngsd", 1). Parallel runs do not exceed the capacity of the resource (see --resource).
+#define USES_RESOURCE(resource, units) \
+	static inline TFW::ResourceRegistrar<TestClassType> TFW_CONCAT(static_resource_, __LINE__){resource, units};
+
+//Declares the memory used by each test method of the class in MB. Parallel runs do not exceed the available memory (see --memory-mb).
+#define MEMORY_MB(memory_mb) \
+	static inline TFW::MemoryRegistrar<TestClassType> static_memory_mb{memory_mb};
+
+//Declares that the test class needs a QApplication (e.g. for widgets or fonts). Otherwise, a QCoreApplication is created.
+#define TEST_NEEDS_GUI \
+	static inline TFW::GuiRegistrar static_reg_needs_gui{};
+
+//Benchmark method: the body is executed with warmup runs and repetitions (see TestExecutor::runBenchmark)
+#define BENCHMARK_METHOD(methodName) \
+	TEST_METHOD(methodName) \
+	{ \
+		runBenchmark(#methodName, [this]{ methodName##_benchmark(); }); \
+	} \
+	void methodName##_benchmark()
+
+//Registers the entry point of a tool, see TFW::registerTool (use at namespace scope, e.g. REGISTER_TOOL("SeqPurge", seqPurgeMain))
+#define REGISTER_TOOL(toolname, function) \
+	static TFW::ToolRegistrar tool_registrar_##function(toolname, function);
+
 #define SKIP(msg)\
 {\
 	TFW::skipped() = true;\
@@ -678,6 +4004,45 @@ namespace TFW
 			return;\
 		}\
 	}
+//Checks that the run time of the function (taking the input size as 'int' argument) does not grow faster than the given complexity class (e.g. TFW::O_N) over the given input sizes.
+#define EXPECT_COMPLEXITY(complexity, sizes, ...)\
+	{\
+		QString tfw_result = TFW::checkComplexity(complexity, sizes, __VA_ARGS__);\
+		if (tfw_result!="")\
+		{\
+			TFW::failed() = true;\
+			TFW::message() = "EXPECT_COMPLEXITY(" + QByteArray(#complexity) + ", " + QByteArray(#sizes) + ", ...) failed\n"\
+						   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__) + "\n"\
+						   + tfw_result.toUtf8();\
+			return;\
+		}\
+	}
+
+//Checks that the expression does not perform more than 'max_allocs' heap allocations (in the current thread). Requires TFW_ALLOC_HOOK.
+#define ALLOC_BUDGET(max_allocs, expr)\
+	{\
+		if (!TFW::allocHookInstalled())\
+		{\
+			TFW::failed() = true;\
+			TFW::message() = "ALLOC_BUDGET(" + QByteArray(#max_allocs) + ", " + QByteArray(#expr) + ") failed\n"\
+						   + "message  : allocation hook not installed - define TFW_ALLOC_HOOK in one source file before including TestFramework.h\n"\
+						   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__);\
+			return;\
+		}\
+		qint64 tfw_allocs_before = TFW::allocCounters().allocations;\
+		expr;\
+		qint64 tfw_allocs = TFW::allocCounters().allocations - tfw_allocs_before;\
+		if (tfw_allocs>(max_allocs))\
+		{\
+			TFW::failed() = true;\
+			TFW::message() = "ALLOC_BUDGET(" + QByteArray(#max_allocs) + ", " + QByteArray(#expr) + ") failed\n"\
+						   + "actual   : " + QByteArray::number(tfw_allocs) + " allocations\n"\
+						   + "expected : " + QByteArray::number((qlonglong)(max_allocs)) + " allocations or less\n"\
+						   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__);\
+			return;\
+		}\
+	}
+
 //##################### tool execution and file comparison macros #####################
 
 #define EXECUTE(toolname, arguments) \
@@ -707,6 +4072,51 @@ namespace TFW
 		}\
 	}
 
+//Starts a tool without waiting for it and returns a handle (see asyncLogFile() and asyncExitCode()). Use WAIT_ALL to wait for the tool and check the error code.
+#define EXECUTE_ASYNC(toolname, arguments) \
+	executeToolAsync(toolname, arguments, false, __FILE__, __LINE__)
+
+//Like EXECUTE_ASYNC, but the error code is ignored.
+#define EXECUTE_ASYNC_FAIL(toolname, arguments) \
+	executeToolAsync(toolname, arguments, true, __FILE__, __LINE__)
+
+#define WAIT_ALL() \
+	{\
+		QString tfw_result = waitForTools();\
+		if (tfw_result!="")\
+		{\
+			TFW::failed() = true;\
+			TFW::message() = "WAIT_ALL() failed\n"\
+						   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__) + "\n"\
+						   + "message  : " + tfw_result.toUtf8();\
+			return;\
+		}\
+	}
+
+//Checks the peak memory (resident set size) of the last executed tool. Only available on Linux - the check passes on other platforms.
+#define MAX_RSS_MB(max_mb)\
+	if (TFW::context().last_usage.valid && TFW::context().last_usage.max_rss_mb>(max_mb))\
+	{\
+		TFW::failed() = true;\
+		TFW::message() = "MAX_RSS_MB(" + QByteArray(#max_mb) + ") failed\n"\
+					   + "actual   : " + QByteArray::number(TFW::context().last_usage.max_rss_mb, 'f', 1) + " MB\n"\
+					   + "log file : " + lastLogFile().toUtf8() + "\n"\
+					   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__);\
+		return;\
+	}
+
+//Checks the CPU time (user and system) of the last executed tool. Only available on Linux - the check passes on other platforms.
+#define MAX_CPU_SECONDS(max_seconds)\
+	if (TFW::context().last_usage.valid && TFW::context().last_usage.user_s+TFW::context().last_usage.system_s>(max_seconds))\
+	{\
+		TFW::failed() = true;\
+		TFW::message() = "MAX_CPU_SECONDS(" + QByteArray(#max_seconds) + ") failed\n"\
+					   + "actual   : " + QByteArray::number(TFW::context().last_usage.user_s+TFW::context().last_usage.system_s, 'f', 2) + " s\n"\
+					   + "log file : " + lastLogFile().toUtf8() + "\n"\
+					   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__);\
+		return;\
+	}
+
 #define COMPARE_FILES(actual, expected)\
 	{\
 		QString tfw_result = TFW::comareFiles(actual, expected, 0.0, true, '\t');\
@@ -759,7 +4169,227 @@ namespace TFW
 		}\
 	}
 
+//Removes lines matching any of the given regular expressions in one pass over the file.
+#define REMOVE_LINES_MULTI(filename, regexps)\
+	{\
+		QString tfw_result = TFW::removeLinesMatching(filename, regexps);\
+		if (tfw_result!="")\
+		{\
+			TFW::failed() = true;\
+			TFW::message() = "REMOVE_LINES_MULTI(" + QByteArray(#filename) + ", " + QByteArray(#regexps) + ") failed\n"\
+						   + "location : " + TFW::name(__FILE__) + ":" + TFW::number(__LINE__) + "\n"\
+						   + "message  : " + tfw_result.toUtf8();\
+			return;\
+		}\
+	}
+
 #define TESTDATA(filename)\
 	 TFW::findTestDataFile(__FILE__, filename)
 
+//##################### allocation hook #####################
+
+//Replacements of the global operator new/delete that count heap allocations per thread.
+//With glibc, malloc/calloc/realloc/free and the aligned allocation functions are replaced as well, so that e.g. the data of QByteArray, QString and QList is counted.
+//Define TFW_ALLOC_HOOK in exactly one source file of the test executable (e.g. main.cpp) before including this header.
+#ifdef TFW_ALLOC_HOOK
+
+#ifdef __GLIBC__
+#include <malloc.h>
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+	void __libc_free(void* ptr);
+	void* __libc_memalign(size_t alignment, size_t size);
+}
+#endif
+
+namespace TFW
+{
+	//Counts an allocation of 'size' bytes that occupies 'usable' bytes
+	inline void countAlloc(size_t size, size_t usable)
+	{
+		AllocCounters& counters = allocCounters();
+		++counters.allocations;
+		counters.bytes += size;
+		counters.live_bytes += usable;
+		if (counters.live_bytes>counters.peak_live_bytes) counters.peak_live_bytes = counters.live_bytes;
+	}
+
+#ifdef __GLIBC__
+	//glibc: malloc and free are replaced as well, so the size of a block is queried from the allocator
+	inline void* countedAlloc(size_t size)
+	{
+		void* ptr = __libc_malloc(size);
+		if (ptr!=nullptr) countAlloc(size, malloc_usable_size(ptr));
+		return ptr;
+	}
+
+	inline void* countedAlignedAlloc(size_t alignment, size_t size)
+	{
+		void* ptr = __libc_memalign(alignment, size);
+		if (ptr!=nullptr) countAlloc(size, malloc_usable_size(ptr));
+		return ptr;
+	}
+
+	inline void countedFree(void* ptr)
+	{
+		if (ptr==nullptr) return;
+		allocCounters().live_bytes -= malloc_usable_size(ptr);
+		__libc_free(ptr);
+	}
+#else
+	//size of the header storing the allocation size (keeps the alignment of malloc)
+	static const size_t alloc_header_size = alignof(std::max_align_t);
+
+	inline void* countedAlloc(size_t size)
+	{
+		char* ptr = static_cast<char*>(malloc(size + alloc_header_size));
+		if (ptr==nullptr) return nullptr;
+		*reinterpret_cast<size_t*>(ptr) = size;
+		countAlloc(size, size);
+		return ptr + alloc_header_size;
+	}
+
+	inline void countedFree(void* ptr)
+	{
+		if (ptr==nullptr) return;
+		char* block = static_cast<char*>(ptr) - alloc_header_size;
+		allocCounters().live_bytes -= *reinterpret_cast<size_t*>(block);
+		free(block);
+	}
+#endif
+
+	static struct AllocHookInstaller
+	{
+		AllocHookInstaller()
+		{
+			allocHookInstalled() = true;
+		}
+	} alloc_hook_installer;
+}
+
+void* operator new(std::size_t size)
+{
+	void* ptr = TFW::countedAlloc(size);
+	if (ptr==nullptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* ptr = TFW::countedAlloc(size);
+	if (ptr==nullptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return TFW::countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return TFW::countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	TFW::countedFree(ptr);
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+	void* malloc(size_t size) noexcept
+	{
+		return TFW::countedAlloc(size);
+	}
+
+	void free(void* ptr) noexcept
+	{
+		TFW::countedFree(ptr);
+	}
+
+	void* calloc(size_t count, size_t size) noexcept
+	{
+		void* ptr = __libc_calloc(count, size);
+		if (ptr!=nullptr) TFW::countAlloc(count * size, malloc_usable_size(ptr));
+		return ptr;
+	}
+
+	void* realloc(void* ptr, size_t size) noexcept
+	{
+		size_t usable_before = ptr==nullptr ? 0 : malloc_usable_size(ptr);
+		void* result = __libc_realloc(ptr, size);
+		if (result==nullptr && ptr!=nullptr && size!=0) return nullptr; //failed: the old block is unchanged
+		TFW::allocCounters().live_bytes -= usable_before;
+		if (result!=nullptr) TFW::countAlloc(size, malloc_usable_size(result));
+		return result;
+	}
+
+	void* reallocarray(void* ptr, size_t count, size_t size) noexcept
+	{
+		if (size!=0 && count > (size_t)-1 / size)
+		{
+			errno = ENOMEM;
+			return nullptr;
+		}
+		return realloc(ptr, count * size);
+	}
+
+	void* memalign(size_t alignment, size_t size) noexcept
+	{
+		return TFW::countedAlignedAlloc(alignment, size);
+	}
+
+	void* aligned_alloc(size_t alignment, size_t size) noexcept
+	{
+		return TFW::countedAlignedAlloc(alignment, size);
+	}
+
+	void* valloc(size_t size) noexcept
+	{
+		return TFW::countedAlignedAlloc(sysconf(_SC_PAGESIZE), size);
+	}
+
+	int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept
+	{
+		if (alignment<sizeof(void*) || (alignment & (alignment-1))!=0) return EINVAL;
+		void* result = TFW::countedAlignedAlloc(alignment, size);
+		if (result==nullptr) return ENOMEM;
+		*ptr = result;
+		return 0;
+	}
+}
+#endif
+
+#endif
+
 #endif // TESTFRAMEWORK_H